@@ -0,0 +1,329 @@
+/** \file accuracy.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <Eigen/Dense>
+#include "dab_spring_simulation.h"
+#include "scenes.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+namespace benchmark
+{
+
+#pragma mark Accuracy Definition
+
+// accuracy versus cost of the integrators on reference scenes without damping
+// the position error is the rms distance of the final mass point positions to the exact solution (if known)
+// or to a leapfrog run with an eight times smaller time step
+// the energy drift is the largest deviation of the total energy from its initial value
+// relative to the largest kinetic energy of the reference run
+
+struct AccuracyRun
+{
+    std::string mSolver;
+    float mTimeStep;
+    unsigned int mStepCount;
+    double mCpuMs;
+    double mPositionError;
+    double mEnergyDrift;
+    bool mStable;
+    bool mPareto;
+};
+
+struct AccuracyScene
+{
+    std::string mName;
+    std::function< Scene<3>*() > mBuild;
+    std::function< std::vector< Eigen::Vector3f >( float pTime ) > mExact;
+    Eigen::Vector3f mGravity;
+    float mDuration;
+    std::vector< float > mTimeSteps;
+};
+
+struct AccuracyResult
+{
+    std::string mName;
+    std::string mReference;
+    std::vector< AccuracyRun > mRuns;
+};
+
+#pragma mark Accuracy Implementation
+
+// kinetic energy, spring potential energy and potential energy of gravity
+// gravity is a force that is applied unscaled to every mass point
+
+inline double
+kineticEnergy( const Simulation<3>& pSimulation )
+{
+    double energy = 0.0;
+
+    for(auto mass : pSimulation.massPoints())
+    {
+        if( mass->mass() > 0.0 ) energy += 0.5 * mass->mass() * mass->velocity().squaredNorm();
+    }
+
+    return energy;
+}
+
+inline double
+totalEnergy( const Simulation<3>& pSimulation )
+{
+    double energy = kineticEnergy( pSimulation );
+
+    for(auto mass : pSimulation.massPoints())
+    {
+        if( mass->mass() > 0.0 ) energy -= pSimulation.gravity().dot( mass->position() );
+    }
+
+    for(auto spring : pSimulation.springs())
+    {
+        double strain = spring->length() - spring->restLength();
+        energy += 0.5 * spring->stiffness() * strain * strain;
+    }
+
+    return energy;
+}
+
+template< class Policy >
+AccuracyRun
+runAccuracy( const std::string& pSolver, const AccuracyScene& pScene, float pTimeStep, const std::vector< Eigen::Vector3f >& pReference, double pEnergyScale, double* pMaxKineticEnergy = nullptr, std::vector< Eigen::Vector3f >* pPositions = nullptr )
+{
+    Scene<3>* scene = pScene.mBuild();
+
+    Simulation<3>& simulation = Simulation<3>::get();
+    simulation.clear();
+    scene->addTo( simulation );
+    simulation.setGravity( pScene.mGravity );
+    simulation.setDamping( 0.0 );
+    simulation.setTimeStep( pTimeStep );
+
+    AccuracyRun run;
+    run.mSolver = pSolver;
+    run.mTimeStep = pTimeStep;
+    run.mStepCount = static_cast<unsigned int>( std::round( pScene.mDuration / pTimeStep ) );
+    run.mStable = true;
+    run.mPareto = false;
+
+    double initialEnergy = totalEnergy( simulation );
+    double maxDrift = 0.0;
+    double maxKineticEnergy = 0.0;
+    double cpuNs = 0.0;
+
+    for(unsigned int sI=0; sI<run.mStepCount; ++sI)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        simulation.updateForces();
+        simulation.template solve<Policy>();
+        simulation.update();
+
+        cpuNs += std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+        // energy bookkeeping is not part of the measured cost
+        double energy = totalEnergy( simulation );
+
+        if( std::isfinite( energy ) == false )
+        {
+            run.mStable = false;
+            break;
+        }
+
+        maxDrift = std::max( maxDrift, std::abs( energy - initialEnergy ) );
+        maxKineticEnergy = std::max( maxKineticEnergy, kineticEnergy( simulation ) );
+    }
+
+    const std::vector< MassPoint<3>* >& massPoints = simulation.massPoints();
+    unsigned int massCount = massPoints.size();
+
+    double squaredError = 0.0;
+    for(unsigned int pI=0; pI<massCount && pI<pReference.size(); ++pI) squaredError += ( massPoints[pI]->position() - pReference[pI] ).squaredNorm();
+
+    run.mCpuMs = cpuNs * 1.0e-6;
+    run.mPositionError = massCount > 0 ? std::sqrt( squaredError / massCount ) : 0.0;
+    run.mEnergyDrift = maxDrift / std::max( pEnergyScale, 1.0e-9 );
+
+    // a solution that drifted far beyond the energy in the system is treated as blown up
+    if( std::isfinite( run.mPositionError ) == false || run.mEnergyDrift > 1.0e3 ) run.mStable = false;
+
+    if( pMaxKineticEnergy != nullptr ) *pMaxKineticEnergy = maxKineticEnergy;
+
+    if( pPositions != nullptr )
+    {
+        pPositions->resize( massCount );
+        for(unsigned int pI=0; pI<massCount; ++pI) (*pPositions)[pI] = massPoints[pI]->position();
+    }
+
+    simulation.clear();
+    delete scene;
+
+    return run;
+}
+
+inline AccuracyResult
+runAccuracyScene( const AccuracyScene& pScene )
+{
+    AccuracyResult result;
+    result.mName = pScene.mName;
+
+    // the reference run provides the energy scale and, if there is no exact solution, the reference positions
+    float minTimeStep = *std::min_element( pScene.mTimeSteps.begin(), pScene.mTimeSteps.end() );
+    std::vector< Eigen::Vector3f > reference;
+    double energyScale = 1.0;
+
+    runAccuracy<LeapFrogPolicy>( "reference", pScene, minTimeStep / 8.0, std::vector< Eigen::Vector3f >(), 1.0, &energyScale, &reference );
+
+    if( pScene.mExact )
+    {
+        reference = pScene.mExact( pScene.mDuration );
+        result.mReference = "exact";
+    }
+    else
+    {
+        result.mReference = "leapfrog dt/8";
+    }
+
+    // further integrators are compared by adding them here
+    for(float timeStep : pScene.mTimeSteps) result.mRuns.push_back( runAccuracy<EulerPolicy>( "euler", pScene, timeStep, reference, energyScale ) );
+    for(float timeStep : pScene.mTimeSteps) result.mRuns.push_back( runAccuracy<LeapFrogPolicy>( "leapfrog", pScene, timeStep, reference, energyScale ) );
+
+    // a run is pareto optimal if no other stable run of the scene is both cheaper and more accurate
+    for(auto& run : result.mRuns)
+    {
+        if( run.mStable == false ) continue;
+
+        run.mPareto = true;
+
+        for(auto& other : result.mRuns)
+        {
+            if( &other == &run || other.mStable == false ) continue;
+
+            bool noWorse = other.mCpuMs <= run.mCpuMs && other.mPositionError <= run.mPositionError;
+            bool better = other.mCpuMs < run.mCpuMs || other.mPositionError < run.mPositionError;
+
+            if( noWorse && better )
+            {
+                run.mPareto = false;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+inline std::vector< AccuracyScene >
+accuracyScenes()
+{
+    std::vector< AccuracyScene > scenes( 3 );
+
+    float stiffness = 100.0;
+    float amplitude = 0.5;
+
+    scenes[0].mName = "oscillator";
+    scenes[0].mBuild = [=]() { return buildOscillator( stiffness, amplitude ); };
+    scenes[0].mExact = [=]( float pTime )
+    {
+        std::vector< Eigen::Vector3f > positions( 2, Eigen::Vector3f( 0.0, 0.0, 0.0 ) );
+        positions[1][0] = 1.0 + amplitude * std::cos( std::sqrt( stiffness ) * pTime );
+        return positions;
+    };
+    scenes[0].mGravity = Eigen::Vector3f( 0.0, 0.0, 0.0 );
+    scenes[0].mDuration = 10.0;
+    scenes[0].mTimeSteps = { 0.02, 0.01, 0.005, 0.0025, 0.00125 };
+
+    scenes[1].mName = "pendulum";
+    scenes[1].mBuild = []() { return buildPendulumChain( 20, 1000.0 ); };
+    scenes[1].mGravity = Eigen::Vector3f( 0.0, -10.0, 0.0 );
+    scenes[1].mDuration = 2.0;
+    scenes[1].mTimeSteps = { 0.01, 0.005, 0.0025, 0.00125, 0.000625 };
+
+    scenes[2].mName = "stiff_lattice";
+    scenes[2].mBuild = []() { return buildStiffLattice( 4, 5000.0 ); };
+    scenes[2].mGravity = Eigen::Vector3f( 0.0, -10.0, 0.0 );
+    scenes[2].mDuration = 1.0;
+    scenes[2].mTimeSteps = { 0.004, 0.002, 0.001, 0.0005, 0.00025 };
+
+    return scenes;
+}
+
+inline void
+printAccuracyTable( const std::vector< AccuracyResult >& pResults )
+{
+    for(auto& result : pResults)
+    {
+        std::cout << result.mName << " (reference " << result.mReference << ")\n";
+
+        std::string solver;
+
+        for(auto& run : result.mRuns)
+        {
+            if( run.mSolver != solver )
+            {
+                solver = run.mSolver;
+                std::cout << "  " << solver << "\n";
+                std::cout << "    " << std::setw( 10 ) << "timeStep" << std::setw( 8 ) << "steps" << std::setw( 12 ) << "cpu ms" << std::setw( 16 ) << "position error" << std::setw( 14 ) << "energy drift" << "  pareto\n";
+            }
+
+            std::cout << "    " << std::setw( 10 ) << run.mTimeStep << std::setw( 8 ) << run.mStepCount << std::setw( 12 ) << run.mCpuMs;
+
+            if( run.mStable ) std::cout << std::setw( 16 ) << run.mPositionError << std::setw( 14 ) << run.mEnergyDrift << ( run.mPareto ? "  *" : "" ) << "\n";
+            else std::cout << std::setw( 16 ) << "unstable" << std::setw( 14 ) << "unstable" << "\n";
+        }
+    }
+}
+
+inline std::string
+accuracyToJson( const std::vector< AccuracyResult >& pResults )
+{
+    std::stringstream ss;
+
+    ss << "{\n  \"accuracy\": [\n";
+
+    for(unsigned int rI=0; rI<pResults.size(); ++rI)
+    {
+        const AccuracyResult& result = pResults[rI];
+
+        ss << "    {\n";
+        ss << "      \"name\": \"" << result.mName << "\",\n";
+        ss << "      \"reference\": \"" << result.mReference << "\",\n";
+        ss << "      \"runs\": [\n";
+
+        for(unsigned int uI=0; uI<result.mRuns.size(); ++uI)
+        {
+            const AccuracyRun& run = result.mRuns[uI];
+
+            ss << "        { \"solver\": \"" << run.mSolver << "\", \"timeStep\": " << run.mTimeStep << ", \"steps\": " << run.mStepCount << ", \"cpuMs\": " << run.mCpuMs << ", \"stable\": " << ( run.mStable ? "true" : "false" );
+            if( run.mStable ) ss << ", \"positionError\": " << run.mPositionError << ", \"energyDrift\": " << run.mEnergyDrift << ", \"pareto\": " << ( run.mPareto ? "true" : "false" );
+            ss << " }" << ( uI + 1 < result.mRuns.size() ? ",\n" : "\n" );
+        }
+
+        ss << "      ]\n";
+        ss << "    }" << ( rI + 1 < pResults.size() ? ",\n" : "\n" );
+    }
+
+    ss << "  ]\n}\n";
+
+    return ss.str();
+}
+
+};
+
+};
+
+};
@@ -0,0 +1,323 @@
+/** \file main.cpp
+
+ headless benchmark of the simulation phases for standard topologies
+ and of the accuracy versus cost of the integrators on reference scenes
+
+ usage: spring_benchmark [--size springCount] [--steps stepCount] [--scene name] [--json file]
+        spring_benchmark --accuracy [--json file]
+        spring_benchmark --snapshot [--size springCount] [--scene name]
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include "dab_spring_simulation.h"
+#include "dab_spring_snapshot.h"
+#include "scenes.h"
+#include "accuracy.h"
+
+using namespace dab::spring;
+using namespace dab::spring::benchmark;
+
+struct PhaseResult
+{
+    std::string mName;
+    double mTotalNs;
+    unsigned int mCount;
+    bool mPerSpring;
+};
+
+struct SceneResult
+{
+    std::string mName;
+    unsigned int mDim;
+    unsigned int mMassPointCount;
+    unsigned int mSpringCount;
+    unsigned int mDirSpringCount;
+    unsigned int mStepCount;
+    std::vector< PhaseResult > mPhases;
+};
+
+template< class Function >
+inline double
+measure( Function pFunction )
+{
+    auto start = std::chrono::steady_clock::now();
+    pFunction();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>( end - start ).count();
+}
+
+template< unsigned int Dim >
+SceneResult
+runScene( const Scene<Dim>& pScene, unsigned int pStepCount )
+{
+    Simulation<Dim>& simulation = Simulation<Dim>::get();
+    simulation.clear();
+    pScene.addTo( simulation );
+
+    Eigen::Matrix<float, Dim, 1> gravity = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+    gravity[Dim - 1] = -0.1;
+    simulation.setGravity( gravity );
+    simulation.setTimeStep( 0.01 );
+
+    SceneResult result;
+    result.mName = pScene.name();
+    result.mDim = Dim;
+    result.mMassPointCount = simulation.massPoints().size();
+    result.mSpringCount = simulation.springs().size();
+    result.mDirSpringCount = simulation.dirSprings().size();
+    result.mStepCount = pStepCount;
+
+    double lengthNs = 0.0;
+    double dirNs = 0.0;
+    double dampingNs = 0.0;
+    double solveNs = 0.0;
+    double updateNs = 0.0;
+    double forcesNs = 0.0;
+
+    // warm up caches and lazily built data before measuring
+    simulation.updateForces();
+    simulation.template solve<LeapFrogPolicy>();
+    simulation.update();
+
+    for(unsigned int sI=0; sI<pStepCount; ++sI)
+    {
+        lengthNs += measure( [&]() { simulation.updateLength(); } );
+        dirNs += measure( [&]() { simulation.updateDir(); } );
+        dampingNs += measure( [&]() { simulation.updateGravity(); simulation.updateDamping(); } );
+        solveNs += measure( [&]() { simulation.template solve<LeapFrogPolicy>(); } );
+        updateNs += measure( [&]() { simulation.update(); } );
+    }
+
+    // same steps with length, gravity and damping fused into one pass over the springs and one over the mass points
+    for(unsigned int sI=0; sI<pStepCount; ++sI)
+    {
+        forcesNs += measure( [&]() { simulation.updateForceTerms( LengthForce<Dim>(), GravityForce<Dim>( simulation.gravity() ), DampingForce<Dim>( simulation.damping() ) ); } );
+        simulation.updateDir();
+        simulation.template solve<LeapFrogPolicy>();
+        simulation.update();
+    }
+
+    result.mPhases.push_back( { "length", lengthNs, result.mSpringCount, true } );
+    result.mPhases.push_back( { "dir", dirNs, result.mDirSpringCount, true } );
+    result.mPhases.push_back( { "gravity_damping", dampingNs, result.mMassPointCount, false } );
+    result.mPhases.push_back( { "forces", forcesNs, result.mSpringCount, true } );
+    result.mPhases.push_back( { "solve", solveNs, result.mMassPointCount, false } );
+    result.mPhases.push_back( { "update", updateNs, result.mMassPointCount, false } );
+
+    simulation.clear();
+
+    return result;
+}
+
+// saves the scene after a few steps, loads it again and compares the loaded snapshot with the simulation
+
+template< unsigned int Dim >
+bool
+checkSnapshot( const Scene<Dim>& pScene, const std::string& pFileName )
+{
+    Simulation<Dim>& simulation = Simulation<Dim>::get();
+    simulation.clear();
+    pScene.addTo( simulation );
+
+    Eigen::Matrix<float, Dim, 1> gravity = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+    gravity[Dim - 1] = -0.1;
+    simulation.setGravity( gravity );
+    simulation.setTimeStep( 0.01 );
+
+    for(unsigned int sI=0; sI<10; ++sI) simulation.template step<LeapFrogPolicy>( 0.01 );
+
+    Snapshot<Dim> snapshot;
+    bool success = Snapshot<Dim>::save( simulation, pFileName ) && snapshot.load( pFileName ) && snapshot.matches( simulation );
+
+    std::remove( pFileName.c_str() );
+    simulation.clear();
+
+    std::cout << pScene.name() << " (" << Dim << "D) snapshot round trip " << ( success ? "ok" : "failed" ) << "\n";
+
+    return success;
+}
+
+double
+perElement( const PhaseResult& pPhase, unsigned int pStepCount )
+{
+    if( pPhase.mCount == 0 || pStepCount == 0 ) return 0.0;
+    return pPhase.mTotalNs / ( static_cast<double>( pPhase.mCount ) * pStepCount );
+}
+
+void
+printTable( const std::vector< SceneResult >& pResults )
+{
+    for(auto& result : pResults)
+    {
+        std::cout << result.mName << " (" << result.mDim << "D) points " << result.mMassPointCount << " springs " << result.mSpringCount << " dirSprings " << result.mDirSpringCount << " steps " << result.mStepCount << "\n";
+
+        for(auto& phase : result.mPhases)
+        {
+            std::cout << "    " << phase.mName << " total " << phase.mTotalNs * 1.0e-6 << " ms, " << perElement( phase, result.mStepCount ) << ( phase.mPerSpring ? " ns/spring" : " ns/point" ) << "\n";
+        }
+    }
+}
+
+std::string
+toJson( const std::vector< SceneResult >& pResults )
+{
+    std::stringstream ss;
+
+    ss << "{\n  \"scenes\": [\n";
+
+    for(unsigned int rI=0; rI<pResults.size(); ++rI)
+    {
+        const SceneResult& result = pResults[rI];
+
+        ss << "    {\n";
+        ss << "      \"name\": \"" << result.mName << "\",\n";
+        ss << "      \"dim\": " << result.mDim << ",\n";
+        ss << "      \"massPoints\": " << result.mMassPointCount << ",\n";
+        ss << "      \"springs\": " << result.mSpringCount << ",\n";
+        ss << "      \"dirSprings\": " << result.mDirSpringCount << ",\n";
+        ss << "      \"steps\": " << result.mStepCount << ",\n";
+        ss << "      \"phases\": {\n";
+
+        for(unsigned int pI=0; pI<result.mPhases.size(); ++pI)
+        {
+            const PhaseResult& phase = result.mPhases[pI];
+
+            ss << "        \"" << phase.mName << "\": { \"totalMs\": " << phase.mTotalNs * 1.0e-6 << ", \"" << ( phase.mPerSpring ? "nsPerSpring" : "nsPerPoint" ) << "\": " << perElement( phase, result.mStepCount ) << " }";
+            ss << ( pI + 1 < result.mPhases.size() ? ",\n" : "\n" );
+        }
+
+        ss << "      }\n";
+        ss << "    }" << ( rI + 1 < pResults.size() ? ",\n" : "\n" );
+    }
+
+    ss << "  ]\n}\n";
+
+    return ss.str();
+}
+
+int
+main( int argc, char* argv[] )
+{
+    unsigned int size = 10000;
+    unsigned int stepCount = 200;
+    std::string sceneFilter;
+    std::string jsonFile;
+    bool accuracy = false;
+    bool snapshot = false;
+
+    for(int aI=1; aI<argc; ++aI)
+    {
+        std::string arg = argv[aI];
+        bool hasValue = aI + 1 < argc;
+
+        if( arg == "--size" && hasValue ) size = std::atoi( argv[++aI] );
+        else if( arg == "--steps" && hasValue ) stepCount = std::atoi( argv[++aI] );
+        else if( arg == "--scene" && hasValue ) sceneFilter = argv[++aI];
+        else if( arg == "--json" && hasValue ) jsonFile = argv[++aI];
+        else if( arg == "--accuracy" ) accuracy = true;
+        else if( arg == "--snapshot" ) snapshot = true;
+        else
+        {
+            std::cout << "usage: " << argv[0] << " [--size springCount] [--steps stepCount] [--scene rope|cloth|lattice|dirtree] [--json file] [--accuracy] [--snapshot]\n";
+            return 1;
+        }
+    }
+
+    std::string json;
+    
+    if( snapshot )
+    {
+        std::string fileName = "spring_benchmark_snapshot.bin";
+        bool success = true;
+
+        if( sceneFilter.empty() || sceneFilter == "rope" )
+        {
+            Scene<3>* scene = buildRope( size );
+            success &= checkSnapshot( *scene, fileName );
+            delete scene;
+        }
+        if( sceneFilter.empty() || sceneFilter == "cloth" )
+        {
+            Scene<2>* scene = buildCloth( size );
+            success &= checkSnapshot( *scene, fileName );
+            delete scene;
+        }
+        if( sceneFilter.empty() || sceneFilter == "lattice" )
+        {
+            Scene<3>* scene = buildLattice( size );
+            success &= checkSnapshot( *scene, fileName );
+            delete scene;
+        }
+        if( sceneFilter.empty() || sceneFilter == "dirtree" )
+        {
+            Scene<3>* scene = buildDirTree( size );
+            success &= checkSnapshot( *scene, fileName );
+            delete scene;
+        }
+
+        return success ? 0 : 1;
+    }
+    
+    if( accuracy )
+    {
+        std::vector< AccuracyResult > accuracyResults;
+        for(auto& scene : accuracyScenes()) accuracyResults.push_back( runAccuracyScene( scene ) );
+
+        printAccuracyTable( accuracyResults );
+        json = accuracyToJson( accuracyResults );
+    }
+    else
+    {
+        std::vector< SceneResult > results;
+
+        if( sceneFilter.empty() || sceneFilter == "rope" )
+        {
+            Scene<3>* scene = buildRope( size );
+            results.push_back( runScene( *scene, stepCount ) );
+            delete scene;
+        }
+        if( sceneFilter.empty() || sceneFilter == "cloth" )
+        {
+            Scene<2>* scene = buildCloth( size );
+            results.push_back( runScene( *scene, stepCount ) );
+            delete scene;
+        }
+        if( sceneFilter.empty() || sceneFilter == "lattice" )
+        {
+            Scene<3>* scene = buildLattice( size );
+            results.push_back( runScene( *scene, stepCount ) );
+            delete scene;
+        }
+        if( sceneFilter.empty() || sceneFilter == "dirtree" )
+        {
+            Scene<3>* scene = buildDirTree( size );
+            results.push_back( runScene( *scene, stepCount ) );
+            delete scene;
+        }
+
+        printTable( results );
+        json = toJson( results );
+    }
+
+    if( jsonFile.empty() == false )
+    {
+        std::ofstream file( jsonFile );
+        if( file.is_open() == false )
+        {
+            std::cout << "could not open " << jsonFile << "\n";
+            return 1;
+        }
+
+        file << json;
+    }
+
+    return 0;
+}
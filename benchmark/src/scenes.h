@@ -0,0 +1,348 @@
+/** \file scenes.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <Eigen/Dense>
+#include "dab_spring_simulation.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+namespace benchmark
+{
+
+#pragma mark Scene Definition
+
+// owns the springs of a benchmark topology and through them the mass points
+// the simulation only references them, so a scene has to outlive its use in the simulation
+
+template< unsigned int Dim >
+class Scene
+{
+public:
+    Scene( const std::string& pName );
+    ~Scene();
+
+    const std::string& name() const;
+    const std::vector< MassPoint<Dim>* >& massPoints() const;
+    const std::vector< Spring<Dim>* >& springs() const;
+    const std::vector< DirSpring<Dim>* >& dirSprings() const;
+
+    MassPoint<Dim>* addMassPoint( float pMass, const Eigen::Matrix<float, Dim, 1>& pPosition );
+    Spring<Dim>* addSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2, float pStiffness, float pDamping );
+    DirSpring<Dim>* addDirSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2, const Eigen::Matrix<float, Dim, 1>& pRestDir, float pStiffness, float pDirStiffness, float pDamping );
+
+    void addTo( Simulation<Dim>& pSimulation ) const;
+
+protected:
+    std::string mName;
+    std::vector< MassPoint<Dim>* > mMassPoints;
+    std::vector< Spring<Dim>* > mSprings;
+    std::vector< DirSpring<Dim>* > mDirSprings;
+};
+
+#pragma mark Scene Implementation
+
+template< unsigned int Dim >
+Scene<Dim>::Scene( const std::string& pName )
+: mName( pName )
+{}
+
+template< unsigned int Dim >
+Scene<Dim>::~Scene()
+{
+    std::vector< Spring<Dim>* > springs( mSprings );
+    springs.insert( springs.end(), mDirSprings.begin(), mDirSprings.end() );
+
+    deleteSprings( mMassPoints, springs );
+}
+
+template< unsigned int Dim >
+const std::string&
+Scene<Dim>::name() const
+{
+    return mName;
+}
+
+template< unsigned int Dim >
+const std::vector< MassPoint<Dim>* >&
+Scene<Dim>::massPoints() const
+{
+    return mMassPoints;
+}
+
+template< unsigned int Dim >
+const std::vector< Spring<Dim>* >&
+Scene<Dim>::springs() const
+{
+    return mSprings;
+}
+
+template< unsigned int Dim >
+const std::vector< DirSpring<Dim>* >&
+Scene<Dim>::dirSprings() const
+{
+    return mDirSprings;
+}
+
+template< unsigned int Dim >
+MassPoint<Dim>*
+Scene<Dim>::addMassPoint( float pMass, const Eigen::Matrix<float, Dim, 1>& pPosition )
+{
+    mMassPoints.push_back( new MassPoint<Dim>( pMass, pPosition ) );
+    return mMassPoints.back();
+}
+
+template< unsigned int Dim >
+Spring<Dim>*
+Scene<Dim>::addSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2, float pStiffness, float pDamping )
+{
+    float restLength = ( pMassPoint2->position() - pMassPoint1->position() ).norm();
+
+    mSprings.push_back( new Spring<Dim>( pMassPoint1, pMassPoint2, restLength, pStiffness, pDamping ) );
+    return mSprings.back();
+}
+
+template< unsigned int Dim >
+DirSpring<Dim>*
+Scene<Dim>::addDirSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2, const Eigen::Matrix<float, Dim, 1>& pRestDir, float pStiffness, float pDirStiffness, float pDamping )
+{
+    float restLength = ( pMassPoint2->position() - pMassPoint1->position() ).norm();
+
+    mDirSprings.push_back( new DirSpring<Dim>( pMassPoint1, pMassPoint2, restLength, pStiffness, pRestDir, pDirStiffness, pDamping ) );
+    return mDirSprings.back();
+}
+
+template< unsigned int Dim >
+void
+Scene<Dim>::addTo( Simulation<Dim>& pSimulation ) const
+{
+    for(auto spring : mSprings) pSimulation.addSpring( spring );
+    for(auto spring : mDirSprings) pSimulation.addSpring( spring );
+}
+
+#pragma mark Scene Builders
+
+// rope of pSpringCount springs hanging from a fixed mass point
+
+inline Scene<3>*
+buildRope( unsigned int pSpringCount )
+{
+    Scene<3>* scene = new Scene<3>( "rope" );
+
+    MassPoint<3>* prevMass = scene->addMassPoint( 0.0, Eigen::Vector3f( 0.0, 0.0, 0.0 ) );
+
+    for(unsigned int sI=0; sI<pSpringCount; ++sI)
+    {
+        MassPoint<3>* mass = scene->addMassPoint( 1.0, Eigen::Vector3f( sI + 1.0, 0.0, 0.0 ) );
+        scene->addSpring( prevMass, mass, 10.0, 0.1 );
+        prevMass = mass;
+    }
+
+    return scene;
+}
+
+// square 2D cloth with structural and shear springs and two fixed corners, roughly pSpringCount springs
+
+inline Scene<2>*
+buildCloth( unsigned int pSpringCount )
+{
+    Scene<2>* scene = new Scene<2>( "cloth" );
+
+    int side = std::max( 2, static_cast<int>( std::sqrt( pSpringCount / 4.0 ) ) + 1 );
+    std::vector< MassPoint<2>* > grid( side * side );
+
+    for(int y=0; y<side; ++y)
+    {
+        for(int x=0; x<side; ++x)
+        {
+            float mass = ( y == 0 && ( x == 0 || x == side - 1 ) ) ? 0.0 : 1.0;
+            grid[x + y * side] = scene->addMassPoint( mass, Eigen::Vector2f( x, -y ) );
+        }
+    }
+
+    for(int y=0; y<side; ++y)
+    {
+        for(int x=0; x<side; ++x)
+        {
+            MassPoint<2>* mass = grid[x + y * side];
+
+            if( x + 1 < side ) scene->addSpring( mass, grid[x + 1 + y * side], 10.0, 0.1 );
+            if( y + 1 < side ) scene->addSpring( mass, grid[x + ( y + 1 ) * side], 10.0, 0.1 );
+            if( x + 1 < side && y + 1 < side ) scene->addSpring( mass, grid[x + 1 + ( y + 1 ) * side], 5.0, 0.1 );
+            if( x > 0 && y + 1 < side ) scene->addSpring( mass, grid[x - 1 + ( y + 1 ) * side], 5.0, 0.1 );
+        }
+    }
+
+    return scene;
+}
+
+// cubic 3D lattice with axis aligned springs and a fixed bottom layer, roughly pSpringCount springs
+
+inline Scene<3>*
+buildLattice( unsigned int pSpringCount )
+{
+    Scene<3>* scene = new Scene<3>( "lattice" );
+
+    int side = std::max( 2, static_cast<int>( std::cbrt( pSpringCount / 3.0 ) ) + 1 );
+    std::vector< MassPoint<3>* > grid( side * side * side );
+
+    for(int z=0; z<side; ++z)
+    {
+        for(int y=0; y<side; ++y)
+        {
+            for(int x=0; x<side; ++x)
+            {
+                float mass = y == 0 ? 0.0 : 1.0;
+                grid[x + ( y + z * side ) * side] = scene->addMassPoint( mass, Eigen::Vector3f( x, y, z ) );
+            }
+        }
+    }
+
+    for(int z=0; z<side; ++z)
+    {
+        for(int y=0; y<side; ++y)
+        {
+            for(int x=0; x<side; ++x)
+            {
+                MassPoint<3>* mass = grid[x + ( y + z * side ) * side];
+
+                if( x + 1 < side ) scene->addSpring( mass, grid[x + 1 + ( y + z * side ) * side], 50.0, 0.1 );
+                if( y + 1 < side ) scene->addSpring( mass, grid[x + ( y + 1 + z * side ) * side], 50.0, 0.1 );
+                if( z + 1 < side ) scene->addSpring( mass, grid[x + ( y + ( z + 1 ) * side ) * side], 50.0, 0.1 );
+            }
+        }
+    }
+
+    return scene;
+}
+
+// binary tree of directional springs on a fixed trunk spring, roughly pSpringCount springs
+
+inline Scene<3>*
+buildDirTree( unsigned int pSpringCount )
+{
+    Scene<3>* scene = new Scene<3>( "dirtree" );
+
+    MassPoint<3>* root = scene->addMassPoint( 0.0, Eigen::Vector3f( 0.0, 0.0, 0.0 ) );
+    MassPoint<3>* trunk = scene->addMassPoint( 0.0, Eigen::Vector3f( 1.0, 0.0, 0.0 ) );
+    scene->addSpring( root, trunk, 10.0, 0.1 );
+
+    const Eigen::Vector3f branchDirs[2] = { Eigen::Vector3f( 1.0, 0.5, 0.0 ).normalized(), Eigen::Vector3f( 1.0, -0.5, 0.25 ).normalized() };
+
+    // breadth first growth, each level shortens the branches
+    std::vector< std::pair< MassPoint<3>*, float > > tips( 1, std::make_pair( trunk, 1.0f ) );
+    std::vector< std::pair< MassPoint<3>*, float > > nextTips;
+    unsigned int springCount = 1;
+
+    while( springCount < pSpringCount )
+    {
+        nextTips.clear();
+
+        for(auto& tip : tips)
+        {
+            for(int bI=0; bI<2 && springCount < pSpringCount; ++bI)
+            {
+                float length = tip.second * 0.9;
+                MassPoint<3>* mass = scene->addMassPoint( 1.0, tip.first->position() + branchDirs[bI] * length );
+                scene->addDirSpring( tip.first, mass, branchDirs[bI], 10.0, 1.0, 0.1 );
+                nextTips.push_back( std::make_pair( mass, length ) );
+                springCount++;
+            }
+        }
+
+        tips.swap( nextTips );
+    }
+
+    return scene;
+}
+
+#pragma mark Accuracy Scene Builders
+
+// undamped harmonic oscillator, a unit mass point on a spring attached to a fixed mass point
+// the spring starts stretched by pAmplitude, the exact solution is x( t ) = 1 + amplitude * cos( sqrt( stiffness ) * t )
+
+inline Scene<3>*
+buildOscillator( float pStiffness, float pAmplitude )
+{
+    Scene<3>* scene = new Scene<3>( "oscillator" );
+
+    MassPoint<3>* anchor = scene->addMassPoint( 0.0, Eigen::Vector3f( 0.0, 0.0, 0.0 ) );
+    MassPoint<3>* mass = scene->addMassPoint( 1.0, Eigen::Vector3f( 1.0 + pAmplitude, 0.0, 0.0 ) );
+    scene->addSpring( anchor, mass, pStiffness, 0.0 )->setRestLength( 1.0 );
+
+    return scene;
+}
+
+// undamped chain of pSpringCount springs that starts horizontally and swings down from a fixed end
+
+inline Scene<3>*
+buildPendulumChain( unsigned int pSpringCount, float pStiffness )
+{
+    Scene<3>* scene = new Scene<3>( "pendulum" );
+
+    MassPoint<3>* prevMass = scene->addMassPoint( 0.0, Eigen::Vector3f( 0.0, 0.0, 0.0 ) );
+
+    for(unsigned int sI=0; sI<pSpringCount; ++sI)
+    {
+        MassPoint<3>* mass = scene->addMassPoint( 1.0, Eigen::Vector3f( sI + 1.0, 0.0, 0.0 ) );
+        scene->addSpring( prevMass, mass, pStiffness, 0.0 );
+        prevMass = mass;
+    }
+
+    return scene;
+}
+
+// small undamped cubic lattice of stiff axis aligned springs that sags and oscillates on a fixed bottom layer
+
+inline Scene<3>*
+buildStiffLattice( int pSide, float pStiffness )
+{
+    Scene<3>* scene = new Scene<3>( "stiff_lattice" );
+
+    int side = std::max( 2, pSide );
+    std::vector< MassPoint<3>* > grid( side * side * side );
+
+    for(int z=0; z<side; ++z)
+    {
+        for(int y=0; y<side; ++y)
+        {
+            for(int x=0; x<side; ++x)
+            {
+                float mass = y == 0 ? 0.0 : 1.0;
+                grid[x + ( y + z * side ) * side] = scene->addMassPoint( mass, Eigen::Vector3f( x, y, z ) );
+            }
+        }
+    }
+
+    for(int z=0; z<side; ++z)
+    {
+        for(int y=0; y<side; ++y)
+        {
+            for(int x=0; x<side; ++x)
+            {
+                MassPoint<3>* mass = grid[x + ( y + z * side ) * side];
+
+                if( x + 1 < side ) scene->addSpring( mass, grid[x + 1 + ( y + z * side ) * side], pStiffness, 0.0 );
+                if( y + 1 < side ) scene->addSpring( mass, grid[x + ( y + 1 + z * side ) * side], pStiffness, 0.0 );
+                if( z + 1 < side ) scene->addSpring( mass, grid[x + ( y + ( z + 1 ) * side ) * side], pStiffness, 0.0 );
+            }
+        }
+    }
+
+    return scene;
+}
+
+};
+
+};
+
+};
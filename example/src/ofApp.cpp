@@ -3,6 +3,7 @@
 #include "dab_spring_spring.h"
 #include "dab_spring_simulation.h"
 #include "dab_spring_solver_leapfrog.h"
+#include "dab_spring_fixed_stepper.h"
 
 //--------------------------------------------------------------
 void ofApp::setup()
@@ -18,6 +19,10 @@ void ofApp::setup()
     
     dab::spring::Simulation<2u>& springSim = dab::spring::Simulation<2>::get();
     springSim.addSpring(mSP);
+    springSim.setRenderExport(true);
+    
+    mStepper.setTimeStep(0.1);
+    mVboBuildCount = 0;
     
     
         //std::cout << "mp1:\n" << *mp1 << "\n";
@@ -31,12 +36,7 @@ void ofApp::update()
     dab::spring::Simulation<2>& springSim = dab::spring::Simulation<2>::get();
     dab::spring::LeapFrogSolver& solver = dab::spring::LeapFrogSolver::get();
     
-    solver.setTimeStep(0.1);
-    
-    springSim.updateLength();
-    springSim.updateDamping();
-    springSim.solve(solver);
-    springSim.update();
+    mStepper.advance(springSim, solver, ofGetLastFrameTime());
     
     std::cout << *mMP1 << "\n";
 }
@@ -46,13 +46,28 @@ void ofApp::draw()
 {
     ofBackground(255, 255, 255);
     
-    const Eigen::Matrix<float, 2, 1>& mp1Pos = mMP1->position();
-    const Eigen::Matrix<float, 2, 1>& mp2Pos = mMP2->position();
+    // the vertices are the stepper's interpolated positions, which are in the same order as the simulation's mass points
+    // a fixed size Eigen vector holds its 2 floats contiguously, so the positions are uploaded without copying
+    // the index buffer of the render export only changes when springs or mass points are added or removed
+    const std::vector< Eigen::Matrix<float, 2, 1> >& positions = mStepper.positions();
+    const dab::spring::RenderBuffer<2>& buffer = dab::spring::Simulation<2>::get().renderBuffer();
+    if( buffer.pointCount() < 2 || positions.size() != buffer.pointCount() ) return;
+    
+    if( mVboBuildCount != buffer.buildCount() )
+    {
+        mVbo.setVertexData( positions[0].data(), 2, positions.size(), GL_DYNAMIC_DRAW );
+        mVbo.setIndexData( buffer.indices().data(), buffer.indices().size(), GL_STATIC_DRAW );
+        mVboBuildCount = buffer.buildCount();
+    }
+    else
+    {
+        mVbo.updateVertexData( positions[0].data(), positions.size() );
+    }
     
     ofSetColor(0, 0, 0);
-    ofDrawCircle(mp1Pos[0], mp1Pos[1], 5.0);
-    ofDrawCircle(mp2Pos[0], mp2Pos[1], 5.0);
-    ofDrawLine(mp1Pos[0], mp1Pos[1], mp2Pos[0], mp2Pos[1]);
+    glPointSize(10.0);
+    mVbo.draw(GL_POINTS, 0, buffer.pointCount());
+    mVbo.drawElements(GL_LINES, buffer.indices().size());
 }
 
 //--------------------------------------------------------------
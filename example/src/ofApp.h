@@ -4,6 +4,7 @@
 #include "dab_spring_mass_point.h"
 #include "dab_spring_spring.h"
 #include "dab_spring_simulation.h"
+#include "dab_spring_fixed_stepper.h"
 
 class ofApp : public ofBaseApp{
     
@@ -27,6 +28,10 @@ public:
     dab::spring::MassPoint<2>* mMP1;
     dab::spring::MassPoint<2>* mMP2;
     dab::spring::Spring<2>* mSP;
+    dab::spring::FixedStepper<2> mStepper;
+    
+    ofVbo mVbo;
+    unsigned long mVboBuildCount;
     
     
 };
@@ -2,3 +2,25 @@
 */
 
 #include "dab_spring_angled_spring.h"
+
+using namespace dab;
+using namespace dab::spring;
+
+template<>
+void
+AngledSpring<2>::update()
+{
+    Spring<2>::update();
+    
+    mAngle1 = atan2( mDirection[1], mDirection[0] );
+}
+
+template<>
+void
+AngledSpring<3>::update()
+{
+    Spring<3>::update();
+    
+    mAngle1 = atan2( mDirection[1], mDirection[0] );
+    mAngle2 = acos( std::max( -1.0f, std::min( mDirection[2], 1.0f ) ) );
+}
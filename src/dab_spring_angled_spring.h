@@ -4,6 +4,8 @@
 #pragma once
 
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 #include "dab_spring_mass_point.h"
 #include "dab_spring_spring.h"
 
@@ -25,6 +27,8 @@ public:
     AngledSpring( const AngledSpring<Dim>& pSpring );
     ~AngledSpring();
     
+    void update();
+    
     inline float angle1() const;
     inline float restAngle1() const;
     inline float relAngle1() const;
@@ -50,6 +54,8 @@ public:
     };
     
 protected:
+    float mAngle1;
+    float mAngle2;
     float mRestAngle1;
     float mRestAngle2;
     float mAngleStiffness;
@@ -64,30 +70,44 @@ typedef AngledSpring<3>  AngledSpring3D;
 template< unsigned int Dim >
 AngledSpring<Dim>::AngledSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2 )
 : Spring<Dim>( pMassPoint1, pMassPoint2 )
+, mAngle1( 0.0 )
+, mAngle2( 0.0 )
 , mRestAngle1( 0.0 )
 , mRestAngle2( 0.0 )
 , mAngleStiffness( 0.0 )
-{}
+{
+    update();
+}
 
 template< unsigned int Dim >
 AngledSpring<Dim>::AngledSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2, float pRestLength, float pStiffness, float pRestAngle1, float pAngleStiffness, float pDamping )
 : Spring<Dim>( pMassPoint1, pMassPoint2, pRestLength, pStiffness, pDamping )
+, mAngle1( 0.0 )
+, mAngle2( 0.0 )
 , mRestAngle1( pRestAngle1 )
 , mRestAngle2( 0.0 )
 , mAngleStiffness( pAngleStiffness )
-{}
+{
+    update();
+}
 
 template< unsigned int Dim >
 AngledSpring<Dim>::AngledSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2, float pRestLength, float pStiffness, float pRestAngle1, float pRestAngle2, float pAngleStiffness, float pDamping )
 : Spring<Dim>( pMassPoint1, pMassPoint2, pRestLength, pStiffness, pDamping )
+, mAngle1( 0.0 )
+, mAngle2( 0.0 )
 , mRestAngle1( pRestAngle1 )
 , mRestAngle2( pRestAngle2 )
 , mAngleStiffness( pAngleStiffness )
-{}
+{
+    update();
+}
 
 template< unsigned int Dim >
 AngledSpring<Dim>::AngledSpring( const AngledSpring<Dim>& pSpring )
 : Spring<Dim>( pSpring )
+, mAngle1( pSpring.mAngle1 )
+, mAngle2( pSpring.mAngle2 )
 , mRestAngle1( pSpring.mRestAngle1 )
 , mRestAngle2( pSpring.mRestAngle2 )
 , mAngleStiffness( pSpring.mAngleStiffness )
@@ -97,13 +117,29 @@ template< unsigned int Dim >
 AngledSpring<Dim>::~AngledSpring()
 {}
 
+template< unsigned int Dim >
+void
+AngledSpring<Dim>::update()
+{
+    // the angles are cached together with length and direction once per step
+    
+    Spring<Dim>::update();
+}
+
+template<>
+void
+AngledSpring<2>::update();
+
+template<>
+void
+AngledSpring<3>::update();
+
 template< unsigned int Dim >
 inline
 float
 AngledSpring<Dim>::angle1() const
 {
-    Eigen::Matrix<float, Dim, 1> springDir = Spring<Dim>::mMassPoint2->position() - Spring<Dim>::mMassPoint1->position();
-    return atan2( springDir[1], springDir[0] );
+    return mAngle1;
 }
 
 template< unsigned int Dim >
@@ -130,15 +166,6 @@ AngledSpring<Dim>::setRestAngle1( float pRestAngle1 )
     mRestAngle1 = pRestAngle1;
 }
 
-template< >
-inline
-float
-AngledSpring<3>::angle2() const
-{
-    Eigen::Matrix<float, 3, 1> springDir = Spring<3>::mMassPoint2->position() - Spring<3>::mMassPoint1->position();
-    return acos( springDir[2] / springDir.norm() );
-}
-
 template< unsigned int Dim >
 inline
 float
@@ -152,7 +179,7 @@ inline
 float
 AngledSpring<Dim>::angle2() const
 {
-    return 0.0;
+    return mAngle2;
 }
 
 template< unsigned int Dim >
@@ -0,0 +1,7 @@
+/** \file dab_spring_barnes_hut.cpp
+*/
+
+#include "dab_spring_barnes_hut.h"
+
+using namespace dab;
+using namespace dab::spring;
@@ -0,0 +1,327 @@
+/** \file dab_spring_barnes_hut.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark PowerLawKernel Definition
+
+// force between two unit charges: strength * d / ( |d|^2 + softening^2 )^( ( exponent + 1 ) / 2 )
+// d points from the source to the receiver, positive strength repels, negative strength attracts
+
+template< unsigned int Dim >
+struct PowerLawKernel
+{
+    float mStrength;
+    float mSoftening;
+    float mExponent;
+
+    PowerLawKernel()
+    : mStrength( 1.0 )
+    , mSoftening( 0.1 )
+    , mExponent( 2.0 )
+    {}
+
+    PowerLawKernel( float pStrength, float pSoftening, float pExponent )
+    : mStrength( pStrength )
+    , mSoftening( pSoftening )
+    , mExponent( pExponent )
+    {}
+
+    inline Eigen::Matrix<float, Dim, 1> operator()( const Eigen::Matrix<float, Dim, 1>& pOffset, float pDistance2, float pCharge ) const
+    {
+        float distance2 = pDistance2 + mSoftening * mSoftening;
+        
+        // inverse square law without pow
+        if( mExponent == 2.0f ) return pOffset * ( mStrength * pCharge / ( distance2 * std::sqrt( distance2 ) ) );
+        
+        return pOffset * ( mStrength * pCharge * std::pow( distance2, -0.5f * ( mExponent + 1.0f ) ) );
+    }
+};
+
+#pragma mark BarnesHutTree Definition
+
+// quadtree (2D) or octree (3D) over point positions, each point carries a unit charge
+// distant nodes are approximated by their total charge placed at their center of charge
+
+template< unsigned int Dim >
+class BarnesHutTree
+{
+public:
+    BarnesHutTree();
+    ~BarnesHutTree();
+
+    float theta() const;
+    unsigned int maxDepth() const;
+    void setTheta( float pTheta );
+    void setMaxDepth( unsigned int pMaxDepth );
+
+    void build( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions );
+    template< class Kernel > Eigen::Matrix<float, Dim, 1> force( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions, unsigned int pIndex, const Kernel& pKernel ) const;
+
+protected:
+    static const int sChildCount = 1 << Dim;
+
+    struct Node
+    {
+        Eigen::Matrix<float, Dim, 1> mCenter;
+        float mHalfSize;
+        Eigen::Matrix<float, Dim, 1> mChargeCenter;
+        float mCharge;
+        int mFirstChild;
+        int mFirstPoint;
+    };
+
+    float mTheta;
+    unsigned int mMaxDepth;
+    std::vector< Node > mNodes;
+    std::vector< int > mNextPoint;
+    mutable std::vector< int > mStack;
+
+    inline int childIndex( const Node& pNode, const Eigen::Matrix<float, Dim, 1>& pPosition ) const;
+    void subdivide( int pNodeIndex );
+};
+
+#pragma mark BarnesHutTree Implementation
+
+template< unsigned int Dim >
+BarnesHutTree<Dim>::BarnesHutTree()
+: mTheta( 0.5 )
+, mMaxDepth( 24 )
+{}
+
+template< unsigned int Dim >
+BarnesHutTree<Dim>::~BarnesHutTree()
+{}
+
+template< unsigned int Dim >
+float
+BarnesHutTree<Dim>::theta() const
+{
+    return mTheta;
+}
+
+template< unsigned int Dim >
+unsigned int
+BarnesHutTree<Dim>::maxDepth() const
+{
+    return mMaxDepth;
+}
+
+template< unsigned int Dim >
+void
+BarnesHutTree<Dim>::setTheta( float pTheta )
+{
+    mTheta = pTheta;
+}
+
+template< unsigned int Dim >
+void
+BarnesHutTree<Dim>::setMaxDepth( unsigned int pMaxDepth )
+{
+    mMaxDepth = pMaxDepth;
+}
+
+template< unsigned int Dim >
+int
+BarnesHutTree<Dim>::childIndex( const Node& pNode, const Eigen::Matrix<float, Dim, 1>& pPosition ) const
+{
+    int index = 0;
+    for(unsigned int d=0; d<Dim; ++d) if( pPosition[d] >= pNode.mCenter[d] ) index |= 1 << d;
+
+    return index;
+}
+
+template< unsigned int Dim >
+void
+BarnesHutTree<Dim>::subdivide( int pNodeIndex )
+{
+    // children are stored contiguously and always after their parent
+
+    int firstChild = mNodes.size();
+    mNodes.resize( firstChild + sChildCount );
+
+    Node& node = mNodes[pNodeIndex];
+    float childHalfSize = node.mHalfSize * 0.5;
+
+    for(int cI=0; cI<sChildCount; ++cI)
+    {
+        Node& child = mNodes[firstChild + cI];
+
+        for(unsigned int d=0; d<Dim; ++d) child.mCenter[d] = node.mCenter[d] + ( ( cI >> d ) & 1 ? childHalfSize : -childHalfSize );
+        child.mHalfSize = childHalfSize;
+        child.mCharge = 0.0;
+        child.mFirstChild = -1;
+        child.mFirstPoint = -1;
+    }
+
+    node.mFirstChild = firstChild;
+}
+
+template< unsigned int Dim >
+void
+BarnesHutTree<Dim>::build( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions )
+{
+    int pointCount = pPositions.size();
+
+    mNodes.clear();
+    mNextPoint.assign( pointCount, -1 );
+
+    if( pointCount == 0 ) return;
+
+    // root cube around all points
+    Eigen::Matrix<float, Dim, 1> minCorner = pPositions[0];
+    Eigen::Matrix<float, Dim, 1> maxCorner = pPositions[0];
+
+    for(int pI=1; pI<pointCount; ++pI)
+    {
+        minCorner = minCorner.cwiseMin( pPositions[pI] );
+        maxCorner = maxCorner.cwiseMax( pPositions[pI] );
+    }
+
+    mNodes.reserve( pointCount * 2 );
+    mNodes.resize( 1 );
+    mNodes[0].mCenter = ( minCorner + maxCorner ) * 0.5;
+    mNodes[0].mHalfSize = std::max( ( maxCorner - minCorner ).maxCoeff() * 0.5f, 0.0001f ) * 1.001f;
+    mNodes[0].mCharge = 0.0;
+    mNodes[0].mFirstChild = -1;
+    mNodes[0].mFirstPoint = -1;
+
+    // insertion, points that still share a leaf at maximum depth are kept in a linked list
+    for(int pI=0; pI<pointCount; ++pI)
+    {
+        const Eigen::Matrix<float, Dim, 1>& position = pPositions[pI];
+        int nodeIndex = 0;
+        unsigned int depth = 0;
+
+        while( true )
+        {
+            if( mNodes[nodeIndex].mFirstChild >= 0 )
+            {
+                nodeIndex = mNodes[nodeIndex].mFirstChild + childIndex( mNodes[nodeIndex], position );
+                depth++;
+                continue;
+            }
+
+            int occupant = mNodes[nodeIndex].mFirstPoint;
+
+            if( occupant < 0 || depth >= mMaxDepth )
+            {
+                mNextPoint[pI] = occupant;
+                mNodes[nodeIndex].mFirstPoint = pI;
+                break;
+            }
+
+            // occupied leaf, push the occupant one level down and try again
+            subdivide( nodeIndex );
+            mNodes[nodeIndex].mFirstPoint = -1;
+
+            int occupantChild = mNodes[nodeIndex].mFirstChild + childIndex( mNodes[nodeIndex], pPositions[occupant] );
+            mNodes[occupantChild].mFirstPoint = occupant;
+        }
+    }
+
+    // charges, children come after their parents so a reverse pass visits children first
+    int nodeCount = mNodes.size();
+
+    for(int nI=nodeCount-1; nI>=0; --nI)
+    {
+        Node& node = mNodes[nI];
+        node.mCharge = 0.0;
+        node.mChargeCenter = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+
+        if( node.mFirstChild >= 0 )
+        {
+            for(int cI=0; cI<sChildCount; ++cI)
+            {
+                const Node& child = mNodes[node.mFirstChild + cI];
+                node.mCharge += child.mCharge;
+                node.mChargeCenter += child.mChargeCenter * child.mCharge;
+            }
+        }
+        else
+        {
+            for(int pI=node.mFirstPoint; pI>=0; pI=mNextPoint[pI])
+            {
+                node.mCharge += 1.0;
+                node.mChargeCenter += pPositions[pI];
+            }
+        }
+
+        if( node.mCharge > 0.0 ) node.mChargeCenter /= node.mCharge;
+    }
+}
+
+template< unsigned int Dim >
+template< class Kernel >
+Eigen::Matrix<float, Dim, 1>
+BarnesHutTree<Dim>::force( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions, unsigned int pIndex, const Kernel& pKernel ) const
+{
+    // force exerted on point pIndex by all other points
+    // a node is approximated if its size divided by its distance is below theta
+    // nodes that contain the point are always opened, for large theta the point would otherwise interact with its own charge
+
+    Eigen::Matrix<float, Dim, 1> force = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+    if( mNodes.size() == 0 ) return force;
+
+    const Eigen::Matrix<float, Dim, 1>& position = pPositions[pIndex];
+    int index = pIndex;
+    float theta2 = mTheta * mTheta;
+
+    Eigen::Matrix<float, Dim, 1> offset;
+    float distance2;
+
+    mStack.clear();
+    mStack.push_back( 0 );
+
+    while( mStack.size() > 0 )
+    {
+        const Node& node = mNodes[ mStack.back() ];
+        mStack.pop_back();
+
+        if( node.mCharge == 0.0 ) continue;
+
+        if( node.mFirstChild < 0 )
+        {
+            for(int pI=node.mFirstPoint; pI>=0; pI=mNextPoint[pI])
+            {
+                if( pI == index ) continue;
+
+                offset = position - pPositions[pI];
+                force += pKernel( offset, offset.squaredNorm(), 1.0 );
+            }
+
+            continue;
+        }
+
+        offset = position - node.mChargeCenter;
+        distance2 = offset.squaredNorm();
+
+        bool contained = ( position - node.mCenter ).cwiseAbs().maxCoeff() <= node.mHalfSize;
+
+        if( contained == false && 4.0 * node.mHalfSize * node.mHalfSize < theta2 * distance2 )
+        {
+            force += pKernel( offset, distance2, node.mCharge );
+            continue;
+        }
+
+        for(int cI=0; cI<sChildCount; ++cI) mStack.push_back( node.mFirstChild + cI );
+    }
+
+    return force;
+}
+
+};
+
+};
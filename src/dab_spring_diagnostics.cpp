@@ -0,0 +1,7 @@
+/** \file dab_spring_diagnostics.cpp
+*/
+
+#include "dab_spring_diagnostics.h"
+
+using namespace dab;
+using namespace dab::spring;
@@ -0,0 +1,69 @@
+/** \file dab_spring_diagnostics.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark Diagnostics Definition
+
+// energy, momentum and strain of a simulation step
+// spring potential energy and strain stem from the state the forces were computed from,
+// kinetic energy and momentum from the state the integration started from
+
+template< unsigned int Dim >
+struct Diagnostics
+{
+    float mKineticEnergy;
+    float mPotentialEnergy;
+    Eigen::Matrix<float, Dim, 1> mMomentum;
+    float mMaxStrain;
+    unsigned long mSimStep;
+
+    Diagnostics()
+    {
+        reset();
+    }
+
+    inline float totalEnergy() const
+    {
+        return mKineticEnergy + mPotentialEnergy;
+    }
+
+    inline void reset()
+    {
+        mKineticEnergy = 0.0;
+        mPotentialEnergy = 0.0;
+        mMomentum = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+        mMaxStrain = 0.0;
+        mSimStep = 0;
+    }
+
+    // called from within the spring and integration loops with values these loops already hold
+    inline void addSpring( float pStiffness, float pLength, float pRestLength )
+    {
+        float elongation = pLength - pRestLength;
+
+        mPotentialEnergy += 0.5 * pStiffness * elongation * elongation;
+        if( pRestLength > 0.0 ) mMaxStrain = std::max( mMaxStrain, std::abs( elongation ) / pRestLength );
+    }
+
+    inline void addMassPoint( float pMass, const Eigen::Matrix<float, Dim, 1>& pVelocity )
+    {
+        mKineticEnergy += 0.5 * pMass * pVelocity.squaredNorm();
+        mMomentum += pVelocity * pMass;
+    }
+};
+
+};
+
+};
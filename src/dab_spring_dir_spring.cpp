@@ -6,6 +6,32 @@
 using namespace dab;
 using namespace dab::spring;
 
+template<>
+void
+DirSpring<2>::update()
+{
+	Spring<2>::update();
+
+	// in 2D the rotation into the frame of the previous spring is fully described by the direction of that spring
+
+	Spring<2>* prevSpring = Spring<2>::firstPrevSpring();
+
+	Eigen::Matrix<float, 2, 1> worldPrevSpringDir;
+
+	if( prevSpring != NULL ) worldPrevSpringDir = prevSpring->direction();
+	else worldPrevSpringDir = sRefDir;
+
+	float rotCos = worldPrevSpringDir[0];
+	float rotSin = worldPrevSpringDir[1];
+
+	mWorldRestDir[0] = rotCos * mRestDir[0] - rotSin * mRestDir[1];
+	mWorldRestDir[1] = rotSin * mRestDir[0] + rotCos * mRestDir[1];
+	mWorldRestDir.normalize();
+
+	mLocalDir[0] = rotCos * Spring<2>::mDirection[0] + rotSin * Spring<2>::mDirection[1];
+	mLocalDir[1] = -rotSin * Spring<2>::mDirection[0] + rotCos * Spring<2>::mDirection[1];
+}
+
 template<>
 void
 DirSpring<3>::update()
@@ -65,12 +65,12 @@ typedef DirSpring<3>  DirSpring3D;
 #pragma mark Directional Spring Implementation
     
 template< unsigned int Dim >
-const Eigen::Matrix<float, Dim, 1> DirSpring<Dim>::sRefDir = Eigen::Matrix<float, Dim, 1>( 1.0, 0.0, 0.0 );
+const Eigen::Matrix<float, Dim, 1> DirSpring<Dim>::sRefDir = Eigen::Matrix<float, Dim, 1>::UnitX();
 
 template< unsigned int Dim >
 DirSpring<Dim>::DirSpring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2 )
 : Spring<Dim>(pMassPoint1, pMassPoint2)
-, mRestDir( 1.0, 0.0, 0.0 )
+, mRestDir( Eigen::Matrix<float, Dim, 1>::UnitX() )
 , mDirStiffness( 0.9 )
 {}
 
@@ -140,9 +140,13 @@ template< unsigned int Dim >
 void
 DirSpring<Dim>::update()
 {
-	// TODO: support other dimensions than 3
+	// TODO: support other dimensions than 2 and 3
 }
 
+template<>
+void
+DirSpring<2>::update();
+
 template<>
 void
 DirSpring<3>::update();
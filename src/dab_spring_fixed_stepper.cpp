@@ -0,0 +1,7 @@
+/** \file dab_spring_fixed_stepper.cpp
+*/
+
+#include "dab_spring_fixed_stepper.h"
+
+using namespace dab;
+using namespace dab::spring;
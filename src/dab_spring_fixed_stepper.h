@@ -0,0 +1,200 @@
+/** \file dab_spring_fixed_stepper.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <Eigen/Dense>
+#include "dab_spring_simulation.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark FixedStepper Definition
+
+template< unsigned int Dim >
+class FixedStepper
+{
+public:
+    FixedStepper();
+    FixedStepper( float pTimeStep, unsigned int pMaxStepsPerFrame );
+    ~FixedStepper();
+
+    float timeStep() const;
+    unsigned int maxStepsPerFrame() const;
+    void setTimeStep( float pTimeStep );
+    void setMaxStepsPerFrame( unsigned int pMaxStepsPerFrame );
+
+    unsigned int stepCount() const;
+    float interpolation() const;
+    const std::vector< Eigen::Matrix<float, Dim, 1> >& positions() const;
+
+    template<class Solver, class... Terms> unsigned int advance( Simulation<Dim>& pSimulation, Solver& pSolver, float pElapsedTime, const Terms&... pTerms );
+    void reset();
+
+protected:
+    float mTimeStep;
+    unsigned int mMaxStepsPerFrame;
+    float mAccumulator;
+    float mInterpolation;
+    unsigned int mStepCount;
+
+    std::vector< Eigen::Matrix<float, Dim, 1> > mPrevPositions;
+    std::vector< Eigen::Matrix<float, Dim, 1> > mPositions;
+
+    void storePositions( const Simulation<Dim>& pSimulation );
+    void interpolatePositions( const Simulation<Dim>& pSimulation );
+};
+
+typedef FixedStepper<1>  FixedStepper1D;
+typedef FixedStepper<2>  FixedStepper2D;
+typedef FixedStepper<3>  FixedStepper3D;
+
+#pragma mark FixedStepper Implementation
+
+template< unsigned int Dim >
+FixedStepper<Dim>::FixedStepper()
+: mTimeStep( 0.1 )
+, mMaxStepsPerFrame( 8 )
+, mAccumulator( 0.0 )
+, mInterpolation( 1.0 )
+, mStepCount( 0 )
+{}
+
+template< unsigned int Dim >
+FixedStepper<Dim>::FixedStepper( float pTimeStep, unsigned int pMaxStepsPerFrame )
+: mTimeStep( pTimeStep )
+, mMaxStepsPerFrame( std::max( pMaxStepsPerFrame, 1u ) )
+, mAccumulator( 0.0 )
+, mInterpolation( 1.0 )
+, mStepCount( 0 )
+{}
+
+template< unsigned int Dim >
+FixedStepper<Dim>::~FixedStepper()
+{}
+
+template< unsigned int Dim >
+float
+FixedStepper<Dim>::timeStep() const
+{
+    return mTimeStep;
+}
+
+template< unsigned int Dim >
+unsigned int
+FixedStepper<Dim>::maxStepsPerFrame() const
+{
+    return mMaxStepsPerFrame;
+}
+
+template< unsigned int Dim >
+void
+FixedStepper<Dim>::setTimeStep( float pTimeStep )
+{
+    mTimeStep = pTimeStep;
+}
+
+template< unsigned int Dim >
+void
+FixedStepper<Dim>::setMaxStepsPerFrame( unsigned int pMaxStepsPerFrame )
+{
+    mMaxStepsPerFrame = std::max( pMaxStepsPerFrame, 1u );
+}
+
+template< unsigned int Dim >
+unsigned int
+FixedStepper<Dim>::stepCount() const
+{
+    return mStepCount;
+}
+
+template< unsigned int Dim >
+float
+FixedStepper<Dim>::interpolation() const
+{
+    return mInterpolation;
+}
+
+template< unsigned int Dim >
+const std::vector< Eigen::Matrix<float, Dim, 1> >&
+FixedStepper<Dim>::positions() const
+{
+    return mPositions;
+}
+
+template< unsigned int Dim >
+template<class Solver, class... Terms>
+unsigned int
+FixedStepper<Dim>::advance( Simulation<Dim>& pSimulation, Solver& pSolver, float pElapsedTime, const Terms&... pTerms )
+{
+    mAccumulator += pElapsedTime;
+    mStepCount = 0;
+
+    if( mPrevPositions.size() != pSimulation.massPoints().size() ) storePositions( pSimulation );
+
+    while( mAccumulator >= mTimeStep && mStepCount < mMaxStepsPerFrame )
+    {
+        storePositions( pSimulation );
+        pSimulation.step( pSolver, mTimeStep, pTerms... );
+
+        mAccumulator -= mTimeStep;
+        mStepCount++;
+    }
+
+    // drop the time that could not be simulated within this frame instead of accumulating it forever
+    if( mAccumulator >= mTimeStep ) mAccumulator = std::fmod( mAccumulator, mTimeStep );
+
+    mInterpolation = mTimeStep > 0.0 ? mAccumulator / mTimeStep : 1.0;
+
+    interpolatePositions( pSimulation );
+
+    return mStepCount;
+}
+
+template< unsigned int Dim >
+void
+FixedStepper<Dim>::reset()
+{
+    mAccumulator = 0.0;
+    mInterpolation = 1.0;
+    mStepCount = 0;
+    mPrevPositions.clear();
+    mPositions.clear();
+}
+
+template< unsigned int Dim >
+void
+FixedStepper<Dim>::storePositions( const Simulation<Dim>& pSimulation )
+{
+    const std::vector< MassPoint<Dim>* >& massPoints = pSimulation.massPoints();
+    int massCount = massPoints.size();
+
+    mPrevPositions.resize( massCount );
+
+    for(int pI=0; pI<massCount; ++pI) mPrevPositions[pI] = massPoints[pI]->position();
+}
+
+template< unsigned int Dim >
+void
+FixedStepper<Dim>::interpolatePositions( const Simulation<Dim>& pSimulation )
+{
+    const std::vector< MassPoint<Dim>* >& massPoints = pSimulation.massPoints();
+    int massCount = massPoints.size();
+
+    mPositions.resize( massCount );
+
+    float alpha = mInterpolation;
+    float alpha_1 = 1.0 - mInterpolation;
+
+    for(int pI=0; pI<massCount; ++pI) mPositions[pI] = mPrevPositions[pI] * alpha_1 + massPoints[pI]->position() * alpha;
+}
+
+};
+
+};
@@ -0,0 +1,7 @@
+/** \file dab_spring_force_term.cpp
+*/
+
+#include "dab_spring_force_term.h"
+
+using namespace dab;
+using namespace dab::spring;
@@ -0,0 +1,136 @@
+/** \file dab_spring_force_term.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <initializer_list>
+#include <Eigen/Dense>
+#include "dab_spring_mass_point.h"
+#include "dab_spring_spring.h"
+#include "dab_spring_diagnostics.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark ForceTerm Definition
+
+// base for force terms that Simulation::updateForceTerms() fuses into one loop over mass points and one loop over springs
+// derived terms hide point() and/or spring() and set sPointTerm and/or sSpringTerm, there are no virtual calls
+// a loop is skipped entirely if none of the fused terms needs it
+
+template< unsigned int Dim >
+struct ForceTerm
+{
+    static const bool sPointTerm = false;
+    static const bool sSpringTerm = false;
+
+    inline void point( MassPoint<Dim>* ) const {}
+    inline void spring( Spring<Dim>* ) const {}
+};
+
+#pragma mark GravityForce Definition
+
+template< unsigned int Dim >
+struct GravityForce : public ForceTerm<Dim>
+{
+    static const bool sPointTerm = true;
+
+    Eigen::Matrix<float, Dim, 1> mGravity;
+
+    GravityForce( const Eigen::Matrix<float, Dim, 1>& pGravity )
+    : mGravity( pGravity )
+    {}
+
+    inline void point( MassPoint<Dim>* pMassPoint ) const
+    {
+        pMassPoint->addForce( mGravity );
+    }
+};
+
+#pragma mark DampingForce Definition
+
+template< unsigned int Dim >
+struct DampingForce : public ForceTerm<Dim>
+{
+    static const bool sPointTerm = true;
+
+    float mDamping;
+
+    DampingForce( float pDamping )
+    : mDamping( pDamping )
+    {}
+
+    inline void point( MassPoint<Dim>* pMassPoint ) const
+    {
+        pMassPoint->addForce( pMassPoint->velocity() * -mDamping );
+    }
+};
+
+#pragma mark LengthForce Definition
+
+// with a diagnostics accumulator the strain and elastic energy of every spring with stiffness are added to it
+
+template< unsigned int Dim >
+struct LengthForce : public ForceTerm<Dim>
+{
+    static const bool sSpringTerm = true;
+
+    Diagnostics<Dim>* mDiagnostics;
+
+    LengthForce( Diagnostics<Dim>* pDiagnostics = NULL )
+    : mDiagnostics( pDiagnostics )
+    {}
+
+    inline void spring( Spring<Dim>* pSpring ) const
+    {
+        float springStiffness = pSpring->stiffness();
+        if( springStiffness == 0.0 ) return;
+
+        MassPoint<Dim>* mass1 = pSpring->massPoint1();
+        MassPoint<Dim>* mass2 = pSpring->massPoint2();
+
+        Eigen::Matrix<float, Dim, 1> force = pSpring->direction() * springStiffness * ( pSpring->length() - pSpring->restLength() );
+        force += ( mass2->velocity() - mass1->velocity() ) * pSpring->damping();
+
+        mass1->addForce( force );
+        mass2->addForce( force * -1.0 );
+
+        if( mDiagnostics != NULL ) mDiagnostics->addSpring( springStiffness, pSpring->length(), pSpring->restLength() );
+    }
+};
+
+#pragma mark ForceTerm Helpers
+
+struct ForceTerms
+{
+    static constexpr bool any( std::initializer_list<bool> pValues )
+    {
+        for( bool value : pValues ) if( value ) return true;
+        return false;
+    }
+
+    // calls each term in order, the initializer list only serves to expand the parameter pack which may be empty
+    template< unsigned int Dim, class... Terms >
+    static inline void point( MassPoint<Dim>* pMassPoint, const Terms&... pTerms )
+    {
+        int expand[] = { 0, ( pTerms.point( pMassPoint ), 0 )... };
+        (void)expand;
+        (void)pMassPoint;
+    }
+
+    template< unsigned int Dim, class... Terms >
+    static inline void spring( Spring<Dim>* pSpring, const Terms&... pTerms )
+    {
+        int expand[] = { 0, ( pTerms.spring( pSpring ), 0 )... };
+        (void)expand;
+        (void)pSpring;
+    }
+};
+
+};
+
+};
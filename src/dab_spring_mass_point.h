@@ -35,6 +35,9 @@ public:
 	inline float mass() const;
 	inline void setMass( float pMass );
 	
+	inline float drag() const;
+	inline void setDrag( float pDrag );
+	
 	inline const Eigen::Matrix<float, Dim, 1>& position() const;
 	inline Eigen::Matrix<float, Dim, 1>& position();
 	inline const Eigen::Matrix<float, Dim, 1>& backupPosition() const;
@@ -67,6 +70,7 @@ public:
 	
 protected:
 	float mMass;
+	float mDrag;
 	Eigen::Matrix<float, Dim, 1> mPosition;
 	Eigen::Matrix<float, Dim, 1> mBackupPosition;
 	Eigen::Matrix<float, Dim, 1> mVelocity;
@@ -85,6 +89,7 @@ template< unsigned int Dim >
 MassPoint<Dim>::MassPoint()
 : mPosition( Eigen::Matrix<float, Dim, 1>::Constant(0.0) )
 , mMass( 0.0 )
+, mDrag( 1.0 )
 , mBackupPosition( Eigen::Matrix<float, Dim, 1>::Constant(0.0) )
 , mVelocity( Eigen::Matrix<float, Dim, 1>::Constant(0.0) )
 , mBackupVelocity( Eigen::Matrix<float, Dim, 1>::Constant(0.0) )
@@ -95,6 +100,7 @@ template< unsigned int Dim >
 MassPoint<Dim>::MassPoint( float pMass, const Eigen::Matrix<float, Dim, 1>& pPosition )
     : mPosition( pPosition )
 , mMass( pMass )
+, mDrag( 1.0 )
 , mBackupPosition( pPosition )
 , mVelocity( Eigen::Matrix<float, Dim, 1>::Constant(0.0) )
 , mBackupVelocity( Eigen::Matrix<float, Dim, 1>::Constant(0.0) )
@@ -105,6 +111,7 @@ template< unsigned int Dim >
 MassPoint<Dim>::MassPoint( const MassPoint<Dim>& pMassPoint )
 : mPosition( pMassPoint.mPosition )
 , mMass( pMassPoint.mMass )
+, mDrag( pMassPoint.mDrag )
 , mBackupPosition( pMassPoint.mBackupPosition )
 , mVelocity( pMassPoint.mVelocity )
 , mBackupVelocity( pMassPoint.mBackupVelocity )
@@ -120,6 +127,7 @@ const MassPoint<Dim>&
 MassPoint<Dim>::operator= ( const MassPoint<Dim>& pMassPoint )
 {
     mMass = pMassPoint.mMass;
+    mDrag = pMassPoint.mDrag;
     mPosition = pMassPoint.mPosition;
     mBackupPosition = pMassPoint.mBackupPosition;
     mVelocity = pMassPoint.mVelocity;
@@ -150,6 +158,20 @@ MassPoint<Dim>::setMass( float pMass )
     mMass = pMass;
 }
     
+template< unsigned int Dim >
+float
+MassPoint<Dim>::drag() const
+{
+    return mDrag;
+}
+    
+template< unsigned int Dim >
+void
+MassPoint<Dim>::setDrag( float pDrag )
+{
+    mDrag = pDrag;
+}
+    
 template< unsigned int Dim >
 const Eigen::Matrix<float, Dim, 1>&
 MassPoint<Dim>::position() const
@@ -272,6 +294,7 @@ MassPoint<Dim>::info(int pPropagationLevel) const
     std::stringstream ss;
     
     ss << "Mass " << mMass << "\n";
+    ss << "Drag " << mDrag << "\n";
     ss << "Position [";
     for(int d=0; d<Dim; ++d) ss << " " << mPosition[d];
     ss << " ]\n";
@@ -0,0 +1,7 @@
+/** \file dab_spring_obstacle.cpp
+*/
+
+#include "dab_spring_obstacle.h"
+
+using namespace dab;
+using namespace dab::spring;
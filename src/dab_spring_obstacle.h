@@ -0,0 +1,392 @@
+/** \file dab_spring_obstacle.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <Eigen/Dense>
+#include "dab_spring_mass_point.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark Obstacle Definition
+
+// static obstacle described by a signed distance field (negative inside)
+// mass points that end up inside an obstacle after integration are projected onto its surface
+
+template< unsigned int Dim >
+class Obstacle
+{
+public:
+    Obstacle();
+    virtual ~Obstacle();
+
+    float restitution() const;
+    float friction() const;
+    void setRestitution( float pRestitution );
+    void setFriction( float pFriction );
+
+    virtual void resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const = 0;
+
+protected:
+    float mRestitution;
+    float mFriction;
+
+    template< class Shape > void resolveShape( const Shape& pShape, const std::vector< MassPoint<Dim>* >& pMassPoints ) const;
+};
+
+#pragma mark PlaneObstacle Definition
+
+template< unsigned int Dim >
+class PlaneObstacle : public Obstacle<Dim>
+{
+public:
+    PlaneObstacle( const Eigen::Matrix<float, Dim, 1>& pPoint, const Eigen::Matrix<float, Dim, 1>& pNormal );
+
+    inline float distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const;
+    void resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const;
+
+protected:
+    Eigen::Matrix<float, Dim, 1> mNormal;
+    float mOffset;
+};
+
+#pragma mark SphereObstacle Definition
+
+template< unsigned int Dim >
+class SphereObstacle : public Obstacle<Dim>
+{
+public:
+    SphereObstacle( const Eigen::Matrix<float, Dim, 1>& pCenter, float pRadius );
+
+    inline float distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const;
+    void resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const;
+
+protected:
+    Eigen::Matrix<float, Dim, 1> mCenter;
+    float mRadius;
+};
+
+#pragma mark BoxObstacle Definition
+
+template< unsigned int Dim >
+class BoxObstacle : public Obstacle<Dim>
+{
+public:
+    BoxObstacle( const Eigen::Matrix<float, Dim, 1>& pCenter, const Eigen::Matrix<float, Dim, 1>& pHalfSize );
+
+    inline float distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const;
+    void resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const;
+
+protected:
+    Eigen::Matrix<float, Dim, 1> mCenter;
+    Eigen::Matrix<float, Dim, 1> mHalfSize;
+};
+
+#pragma mark GridObstacle Definition
+
+// precomputed signed distances sampled on a regular grid, x varies fastest
+// distances are interpolated multilinearly, positions outside of the grid are not affected
+// the grid needs at least two samples along every axis and exactly one distance per sample,
+// otherwise the obstacle is invalid and affects no position
+
+template< unsigned int Dim >
+class GridObstacle : public Obstacle<Dim>
+{
+public:
+    GridObstacle( const Eigen::Matrix<float, Dim, 1>& pOrigin, float pCellSize, const Eigen::Matrix<int, Dim, 1>& pResolution, const std::vector<float>& pDistances );
+
+    bool valid() const;
+
+    inline float distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const;
+    void resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const;
+
+protected:
+    bool mValid;
+    Eigen::Matrix<float, Dim, 1> mOrigin;
+    float mCellSize;
+    Eigen::Matrix<int, Dim, 1> mResolution;
+    Eigen::Matrix<int, Dim, 1> mStrides;
+    std::vector<float> mDistances;
+};
+
+typedef Obstacle<2>  Obstacle2D;
+typedef Obstacle<3>  Obstacle3D;
+
+#pragma mark Obstacle Implementation
+
+template< unsigned int Dim >
+Obstacle<Dim>::Obstacle()
+: mRestitution( 0.0 )
+, mFriction( 0.1 )
+{}
+
+template< unsigned int Dim >
+Obstacle<Dim>::~Obstacle()
+{}
+
+template< unsigned int Dim >
+float
+Obstacle<Dim>::restitution() const
+{
+    return mRestitution;
+}
+
+template< unsigned int Dim >
+float
+Obstacle<Dim>::friction() const
+{
+    return mFriction;
+}
+
+template< unsigned int Dim >
+void
+Obstacle<Dim>::setRestitution( float pRestitution )
+{
+    mRestitution = pRestitution;
+}
+
+template< unsigned int Dim >
+void
+Obstacle<Dim>::setFriction( float pFriction )
+{
+    mFriction = pFriction;
+}
+
+template< unsigned int Dim >
+template< class Shape >
+void
+Obstacle<Dim>::resolveShape( const Shape& pShape, const std::vector< MassPoint<Dim>* >& pMassPoints ) const
+{
+    // operates on the integrated state (backup position and velocity) of the mass points
+    // the distance function of the shape is inlined, there is one virtual call per obstacle and not per mass point
+
+    int massCount = pMassPoints.size();
+
+    MassPoint<Dim>* mass;
+    Eigen::Matrix<float, Dim, 1> normal;
+    float distance;
+    float normalVelocity;
+
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        mass = pMassPoints[pI];
+        if( mass->mass() <= 0.0 ) continue;
+
+        Eigen::Matrix<float, Dim, 1>& position = mass->backupPosition();
+        Eigen::Matrix<float, Dim, 1>& velocity = mass->backupVelocity();
+
+        distance = pShape.distance( position, normal );
+        if( distance >= 0.0 ) continue;
+
+        position -= normal * distance;
+
+        normalVelocity = velocity.dot( normal );
+        if( normalVelocity >= 0.0 ) continue;
+
+        Eigen::Matrix<float, Dim, 1> tangentVelocity = velocity - normal * normalVelocity;
+        velocity = tangentVelocity * ( 1.0 - mFriction ) - normal * ( normalVelocity * mRestitution );
+    }
+}
+
+#pragma mark PlaneObstacle Implementation
+
+template< unsigned int Dim >
+PlaneObstacle<Dim>::PlaneObstacle( const Eigen::Matrix<float, Dim, 1>& pPoint, const Eigen::Matrix<float, Dim, 1>& pNormal )
+: Obstacle<Dim>()
+, mNormal( pNormal.normalized() )
+, mOffset( pPoint.dot( pNormal.normalized() ) )
+{}
+
+template< unsigned int Dim >
+float
+PlaneObstacle<Dim>::distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const
+{
+    pNormal = mNormal;
+    return pPosition.dot( mNormal ) - mOffset;
+}
+
+template< unsigned int Dim >
+void
+PlaneObstacle<Dim>::resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const
+{
+    Obstacle<Dim>::resolveShape( *this, pMassPoints );
+}
+
+#pragma mark SphereObstacle Implementation
+
+template< unsigned int Dim >
+SphereObstacle<Dim>::SphereObstacle( const Eigen::Matrix<float, Dim, 1>& pCenter, float pRadius )
+: Obstacle<Dim>()
+, mCenter( pCenter )
+, mRadius( pRadius )
+{}
+
+template< unsigned int Dim >
+float
+SphereObstacle<Dim>::distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const
+{
+    pNormal = pPosition - mCenter;
+    float centerDistance = pNormal.norm();
+
+    if( centerDistance > 0.0 ) pNormal /= centerDistance;
+    else pNormal = Eigen::Matrix<float, Dim, 1>::Unit( 0 );
+
+    return centerDistance - mRadius;
+}
+
+template< unsigned int Dim >
+void
+SphereObstacle<Dim>::resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const
+{
+    Obstacle<Dim>::resolveShape( *this, pMassPoints );
+}
+
+#pragma mark BoxObstacle Implementation
+
+template< unsigned int Dim >
+BoxObstacle<Dim>::BoxObstacle( const Eigen::Matrix<float, Dim, 1>& pCenter, const Eigen::Matrix<float, Dim, 1>& pHalfSize )
+: Obstacle<Dim>()
+, mCenter( pCenter )
+, mHalfSize( pHalfSize )
+{}
+
+template< unsigned int Dim >
+float
+BoxObstacle<Dim>::distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const
+{
+    Eigen::Matrix<float, Dim, 1> local = pPosition - mCenter;
+    Eigen::Matrix<float, Dim, 1> excess = local.cwiseAbs() - mHalfSize;
+
+    int axis;
+    float maxExcess = excess.maxCoeff( &axis );
+
+    if( maxExcess < 0.0 )
+    {
+        // inside, the closest face is the one with the largest (least negative) excess
+        pNormal = Eigen::Matrix<float, Dim, 1>::Unit( axis ) * ( local[axis] < 0.0 ? -1.0 : 1.0 );
+        return maxExcess;
+    }
+
+    Eigen::Matrix<float, Dim, 1> outside = excess.cwiseMax( 0.0f );
+    float outsideDistance = outside.norm();
+
+    pNormal = outside.cwiseProduct( local.cwiseSign() ) / outsideDistance;
+
+    return outsideDistance;
+}
+
+template< unsigned int Dim >
+void
+BoxObstacle<Dim>::resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const
+{
+    Obstacle<Dim>::resolveShape( *this, pMassPoints );
+}
+
+#pragma mark GridObstacle Implementation
+
+template< unsigned int Dim >
+GridObstacle<Dim>::GridObstacle( const Eigen::Matrix<float, Dim, 1>& pOrigin, float pCellSize, const Eigen::Matrix<int, Dim, 1>& pResolution, const std::vector<float>& pDistances )
+: Obstacle<Dim>()
+, mValid( false )
+, mOrigin( pOrigin )
+, mCellSize( pCellSize )
+, mResolution( pResolution )
+, mDistances( pDistances )
+{
+    size_t stride = 1;
+    bool valid = pCellSize > 0.0;
+
+    for(unsigned int d=0; d<Dim; ++d)
+    {
+        mStrides[d] = stride;
+
+        if( mResolution[d] < 2 ) valid = false;
+        else stride *= mResolution[d];
+    }
+
+    mValid = valid && mDistances.size() == stride;
+
+    if( mValid == false ) mDistances.clear();
+}
+
+template< unsigned int Dim >
+bool
+GridObstacle<Dim>::valid() const
+{
+    return mValid;
+}
+
+template< unsigned int Dim >
+float
+GridObstacle<Dim>::distance( const Eigen::Matrix<float, Dim, 1>& pPosition, Eigen::Matrix<float, Dim, 1>& pNormal ) const
+{
+    if( mValid == false ) return std::numeric_limits<float>::max();
+
+    Eigen::Matrix<float, Dim, 1> gridPosition = ( pPosition - mOrigin ) / mCellSize;
+    Eigen::Matrix<int, Dim, 1> cell;
+    Eigen::Matrix<float, Dim, 1> fraction;
+
+    for(unsigned int d=0; d<Dim; ++d)
+    {
+        if( gridPosition[d] < 0.0 || gridPosition[d] > mResolution[d] - 1 ) return std::numeric_limits<float>::max();
+
+        cell[d] = std::min( static_cast<int>( gridPosition[d] ), mResolution[d] - 2 );
+        fraction[d] = gridPosition[d] - cell[d];
+    }
+
+    int baseIndex = cell.dot( mStrides );
+    float distance = 0.0;
+    Eigen::Matrix<float, Dim, 1> gradient = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+
+    // multilinear interpolation over the 2^Dim cell corners, the gradient is the derivative of the interpolant
+    for(int corner=0; corner<(1 << Dim); ++corner)
+    {
+        int index = baseIndex;
+        float weight = 1.0;
+        Eigen::Matrix<float, Dim, 1> weights;
+
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            bool upper = ( corner >> d ) & 1;
+            if( upper ) index += mStrides[d];
+            weights[d] = upper ? fraction[d] : 1.0 - fraction[d];
+            weight *= weights[d];
+        }
+
+        float value = mDistances[index];
+        distance += weight * value;
+
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            float axisWeight = ( corner >> d ) & 1 ? 1.0 : -1.0;
+            for(unsigned int d2=0; d2<Dim; ++d2) if( d2 != d ) axisWeight *= weights[d2];
+            gradient[d] += axisWeight * value;
+        }
+    }
+
+    float gradientLength = gradient.norm();
+    if( gradientLength > 0.0 ) pNormal = gradient / gradientLength;
+    else pNormal = Eigen::Matrix<float, Dim, 1>::Unit( 0 );
+
+    return distance;
+}
+
+template< unsigned int Dim >
+void
+GridObstacle<Dim>::resolve( const std::vector< MassPoint<Dim>* >& pMassPoints ) const
+{
+    Obstacle<Dim>::resolveShape( *this, pMassPoints );
+}
+
+};
+
+};
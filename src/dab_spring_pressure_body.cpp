@@ -0,0 +1,7 @@
+/** \file dab_spring_pressure_body.cpp
+*/
+
+#include "dab_spring_pressure_body.h"
+
+using namespace dab;
+using namespace dab::spring;
@@ -0,0 +1,286 @@
+/** \file dab_spring_pressure_body.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <Eigen/Dense>
+#include "dab_spring_mass_point.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark PressureFace Definition
+
+// signed volume spanned by a face and the origin and its gradient with respect to the face corners
+// faces are edges in 2D and triangles in 3D, counter clockwise faces (seen from outside) enclose a positive volume
+
+template< unsigned int Dim >
+struct PressureFace
+{
+    static inline float volume( const std::array< Eigen::Matrix<float, Dim, 1>, Dim >&, std::array< Eigen::Matrix<float, Dim, 1>, Dim >& pGradients )
+    {
+        for(unsigned int d=0; d<Dim; ++d) pGradients[d] = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+        return 0.0;
+    }
+};
+
+template< >
+struct PressureFace<2>
+{
+    static inline float volume( const std::array< Eigen::Matrix<float, 2, 1>, 2 >& pCorners, std::array< Eigen::Matrix<float, 2, 1>, 2 >& pGradients )
+    {
+        const Eigen::Matrix<float, 2, 1>& p0 = pCorners[0];
+        const Eigen::Matrix<float, 2, 1>& p1 = pCorners[1];
+
+        pGradients[0] << 0.5 * p1[1], -0.5 * p1[0];
+        pGradients[1] << -0.5 * p0[1], 0.5 * p0[0];
+
+        return 0.5 * ( p0[0] * p1[1] - p1[0] * p0[1] );
+    }
+};
+
+template< >
+struct PressureFace<3>
+{
+    static inline float volume( const std::array< Eigen::Matrix<float, 3, 1>, 3 >& pCorners, std::array< Eigen::Matrix<float, 3, 1>, 3 >& pGradients )
+    {
+        const Eigen::Matrix<float, 3, 1>& p0 = pCorners[0];
+        const Eigen::Matrix<float, 3, 1>& p1 = pCorners[1];
+        const Eigen::Matrix<float, 3, 1>& p2 = pCorners[2];
+
+        pGradients[0] = p1.cross( p2 ) / 6.0;
+        pGradients[1] = p2.cross( p0 ) / 6.0;
+        pGradients[2] = p0.cross( p1 ) / 6.0;
+
+        return p0.dot( pGradients[0] );
+    }
+};
+
+#pragma mark PressureBody Definition
+
+// closed surface of mass points whose enclosed volume (area in 2D) is preserved by a pressure force
+// the force on each vertex is ( stiffness * ( restVolume - volume ) / restVolume + pressure ) * dVolume / dVertex
+
+template< unsigned int Dim >
+class PressureBody
+{
+public:
+    PressureBody();
+    PressureBody( const std::vector< MassPoint<Dim>* >& pVertices, const std::vector< std::array<unsigned int, Dim> >& pFaces );
+    ~PressureBody();
+
+    const std::vector< MassPoint<Dim>* >& vertices() const;
+    const std::vector< std::array<unsigned int, Dim> >& faces() const;
+    unsigned int addVertex( MassPoint<Dim>* pVertex );
+    bool addFace( const std::array<unsigned int, Dim>& pFace );
+
+    float volume() const;
+    float restVolume() const;
+    float stiffness() const;
+    float pressure() const;
+    void setRestVolume( float pRestVolume );
+    void setStiffness( float pStiffness );
+    void setPressure( float pPressure );
+    void captureRestVolume();
+
+    void update();
+
+protected:
+    std::vector< MassPoint<Dim>* > mVertices;
+    std::vector< std::array<unsigned int, Dim> > mFaces;
+
+    float mVolume;
+    float mRestVolume;
+    float mStiffness;
+    float mPressure;
+
+    std::vector< std::array< Eigen::Matrix<float, Dim, 1>, Dim > > mFaceGradients;
+
+    float computeVolume();
+};
+
+typedef PressureBody<2>  PressureBody2D;
+typedef PressureBody<3>  PressureBody3D;
+
+#pragma mark PressureBody Implementation
+
+template< unsigned int Dim >
+PressureBody<Dim>::PressureBody()
+: mVolume( 0.0 )
+, mRestVolume( 0.0 )
+, mStiffness( 1.0 )
+, mPressure( 0.0 )
+{}
+
+template< unsigned int Dim >
+PressureBody<Dim>::PressureBody( const std::vector< MassPoint<Dim>* >& pVertices, const std::vector< std::array<unsigned int, Dim> >& pFaces )
+: mVertices( pVertices )
+, mVolume( 0.0 )
+, mRestVolume( 0.0 )
+, mStiffness( 1.0 )
+, mPressure( 0.0 )
+{
+    // faces with a vertex index out of range are dropped, compare faces() with pFaces to detect them
+    mFaces.reserve( pFaces.size() );
+    for(auto& face : pFaces) addFace( face );
+
+    captureRestVolume();
+}
+
+template< unsigned int Dim >
+PressureBody<Dim>::~PressureBody()
+{}
+
+template< unsigned int Dim >
+const std::vector< MassPoint<Dim>* >&
+PressureBody<Dim>::vertices() const
+{
+    return mVertices;
+}
+
+template< unsigned int Dim >
+const std::vector< std::array<unsigned int, Dim> >&
+PressureBody<Dim>::faces() const
+{
+    return mFaces;
+}
+
+template< unsigned int Dim >
+unsigned int
+PressureBody<Dim>::addVertex( MassPoint<Dim>* pVertex )
+{
+    mVertices.push_back( pVertex );
+    return mVertices.size() - 1;
+}
+
+template< unsigned int Dim >
+bool
+PressureBody<Dim>::addFace( const std::array<unsigned int, Dim>& pFace )
+{
+    // faces with a vertex index out of range are rejected
+    for(unsigned int d=0; d<Dim; ++d)
+    {
+        if( pFace[d] >= mVertices.size() ) return false;
+    }
+
+    mFaces.push_back( pFace );
+
+    return true;
+}
+
+template< unsigned int Dim >
+float
+PressureBody<Dim>::volume() const
+{
+    return mVolume;
+}
+
+template< unsigned int Dim >
+float
+PressureBody<Dim>::restVolume() const
+{
+    return mRestVolume;
+}
+
+template< unsigned int Dim >
+float
+PressureBody<Dim>::stiffness() const
+{
+    return mStiffness;
+}
+
+template< unsigned int Dim >
+float
+PressureBody<Dim>::pressure() const
+{
+    return mPressure;
+}
+
+template< unsigned int Dim >
+void
+PressureBody<Dim>::setRestVolume( float pRestVolume )
+{
+    mRestVolume = pRestVolume;
+}
+
+template< unsigned int Dim >
+void
+PressureBody<Dim>::setStiffness( float pStiffness )
+{
+    mStiffness = pStiffness;
+}
+
+template< unsigned int Dim >
+void
+PressureBody<Dim>::setPressure( float pPressure )
+{
+    mPressure = pPressure;
+}
+
+template< unsigned int Dim >
+void
+PressureBody<Dim>::captureRestVolume()
+{
+    mRestVolume = computeVolume();
+}
+
+template< unsigned int Dim >
+float
+PressureBody<Dim>::computeVolume()
+{
+    // volume and per face gradients in a single pass over the faces
+    // faces are independent, the volume is summed with a reduction when compiled with -fopenmp
+
+    int faceCount = mFaces.size();
+    mFaceGradients.resize( faceCount );
+
+    float volume = 0.0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for reduction(+:volume)
+#endif
+    for(int fI=0; fI<faceCount; ++fI)
+    {
+        const std::array<unsigned int, Dim>& face = mFaces[fI];
+        std::array< Eigen::Matrix<float, Dim, 1>, Dim > corners;
+
+        for(unsigned int d=0; d<Dim; ++d) corners[d] = mVertices[ face[d] ]->position();
+
+        volume += PressureFace<Dim>::volume( corners, mFaceGradients[fI] );
+    }
+
+    mVolume = volume;
+
+    return volume;
+}
+
+template< unsigned int Dim >
+void
+PressureBody<Dim>::update()
+{
+    computeVolume();
+
+    float scale = mPressure;
+    if( mRestVolume != 0.0 ) scale += mStiffness * ( mRestVolume - mVolume ) / mRestVolume;
+    if( scale == 0.0 ) return;
+
+    int faceCount = mFaces.size();
+
+    for(int fI=0; fI<faceCount; ++fI)
+    {
+        const std::array<unsigned int, Dim>& face = mFaces[fI];
+        const std::array< Eigen::Matrix<float, Dim, 1>, Dim >& gradients = mFaceGradients[fI];
+
+        for(unsigned int d=0; d<Dim; ++d) mVertices[ face[d] ]->addForce( gradients[d] * scale );
+    }
+}
+
+};
+
+};
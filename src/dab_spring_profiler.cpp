@@ -0,0 +1,109 @@
+/** \file dab_spring_profiler.cpp
+*/
+
+#include "dab_spring_profiler.h"
+#include <algorithm>
+
+using namespace dab;
+using namespace dab::spring;
+
+#pragma mark Profiler implementation
+
+Profiler::Profiler()
+: Profiler( 256 )
+{}
+
+Profiler::Profiler( unsigned int pWindowSize )
+: mWindowSize( std::max( pWindowSize, 1u ) )
+{
+    reset();
+}
+
+Profiler::~Profiler()
+{}
+
+const char*
+Profiler::phaseName( Phase pPhase )
+{
+    static const char* sPhaseNames[PhaseCount] = { "length", "angle", "dir", "gravity_damping", "integration", "backup_refresh", "spring_geometry" };
+
+    if( pPhase >= PhaseCount ) return "unknown";
+    return sPhaseNames[pPhase];
+}
+
+unsigned int
+Profiler::windowSize() const
+{
+    return mWindowSize;
+}
+
+void
+Profiler::setWindowSize( unsigned int pWindowSize )
+{
+    mWindowSize = std::max( pWindowSize, 1u );
+    reset();
+}
+
+void
+Profiler::endStep()
+{
+    for(int pI=0; pI<PhaseCount; ++pI)
+    {
+        mSamples[pI][mSampleIndex] = mStepTimes[pI];
+        mLastCounts[pI] = mStepCounts[pI];
+        mStepTimes[pI] = 0.0;
+        mStepCounts[pI] = 0;
+    }
+
+    mSampleIndex = ( mSampleIndex + 1 ) % mWindowSize;
+    mSampleCount = std::min( mSampleCount + 1, mWindowSize );
+}
+
+Profiler::Statistics
+Profiler::statistics( Phase pPhase ) const
+{
+    Statistics statistics = { 0.0, 0.0, 0.0, 0.0, 0, mSampleCount };
+    if( pPhase >= PhaseCount || mSampleCount == 0 ) return statistics;
+
+    const std::vector<float>& samples = mSamples[pPhase];
+
+    // the most recent sample sits just before the write index
+    statistics.mLastNs = samples[ ( mSampleIndex + mWindowSize - 1 ) % mWindowSize ];
+    statistics.mLastCount = mLastCounts[pPhase];
+
+    // until the window is full the valid samples are the first mSampleCount ones, afterwards all of them
+    mSortedSamples.assign( samples.begin(), samples.begin() + mSampleCount );
+
+    unsigned int p99Index = std::min( static_cast<unsigned int>( mSampleCount * 0.99 ), mSampleCount - 1 );
+    std::nth_element( mSortedSamples.begin(), mSortedSamples.begin() + p99Index, mSortedSamples.end() );
+    statistics.mP99Ns = mSortedSamples[p99Index];
+
+    double sum = 0.0;
+    float minimum = mSortedSamples[0];
+
+    for(unsigned int sI=0; sI<mSampleCount; ++sI)
+    {
+        sum += mSortedSamples[sI];
+        minimum = std::min( minimum, mSortedSamples[sI] );
+    }
+
+    statistics.mMinNs = minimum;
+    statistics.mMeanNs = sum / mSampleCount;
+
+    return statistics;
+}
+
+void
+Profiler::reset()
+{
+    mSampleIndex = 0;
+    mSampleCount = 0;
+
+    for(int pI=0; pI<PhaseCount; ++pI)
+    {
+        mStepTimes[pI] = 0.0;
+        mStepCounts[pI] = 0;
+        mLastCounts[pI] = 0;
+        mSamples[pI].assign( mWindowSize, 0.0 );
+    }
+}
@@ -0,0 +1,126 @@
+/** \file dab_spring_profiler.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <chrono>
+
+// per phase timing of the simulation, only compiled into Simulation if DAB_SPRING_PROFILE is defined
+
+#ifdef DAB_SPRING_PROFILE
+#define DAB_SPRING_PROFILE_CONCAT2( pA, pB ) pA##pB
+#define DAB_SPRING_PROFILE_CONCAT( pA, pB ) DAB_SPRING_PROFILE_CONCAT2( pA, pB )
+#define DAB_SPRING_PROFILE_SCOPE( pPhase, pCount ) dab::spring::ProfileScope DAB_SPRING_PROFILE_CONCAT( profileScope, __LINE__ )( mProfiler, dab::spring::Profiler::pPhase, pCount )
+#define DAB_SPRING_PROFILE_END_STEP() mProfiler.endStep()
+#else
+#define DAB_SPRING_PROFILE_SCOPE( pPhase, pCount )
+#define DAB_SPRING_PROFILE_END_STEP()
+#endif
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark Profiler Definition
+
+// times and element counts are summed per phase over a simulation step
+// this is a call to Simulation::step() including all its sub steps or a call to Simulation::update() outside of step()
+// statistics are taken over a rolling window of the most recent steps
+
+class Profiler
+{
+public:
+    enum Phase
+    {
+        LengthPhase,
+        AnglePhase,
+        DirPhase,
+        GravityDampingPhase,
+        IntegrationPhase,
+        BackupRefreshPhase,
+        SpringGeometryPhase,
+        PhaseCount
+    };
+
+    struct Statistics
+    {
+        float mMinNs;
+        float mMeanNs;
+        float mP99Ns;
+        float mLastNs;
+        unsigned long mLastCount;
+        unsigned int mSampleCount;
+    };
+
+    Profiler();
+    Profiler( unsigned int pWindowSize );
+    ~Profiler();
+
+    static const char* phaseName( Phase pPhase );
+
+    unsigned int windowSize() const;
+    void setWindowSize( unsigned int pWindowSize );
+
+    inline void add( Phase pPhase, double pTimeNs, unsigned long pCount );
+    void endStep();
+    Statistics statistics( Phase pPhase ) const;
+    void reset();
+
+protected:
+    unsigned int mWindowSize;
+    unsigned int mSampleIndex;
+    unsigned int mSampleCount;
+
+    std::array< double, PhaseCount > mStepTimes;
+    std::array< unsigned long, PhaseCount > mStepCounts;
+    std::array< unsigned long, PhaseCount > mLastCounts;
+    std::array< std::vector<float>, PhaseCount > mSamples;
+    mutable std::vector<float> mSortedSamples;
+};
+
+#pragma mark ProfileScope Definition
+
+class ProfileScope
+{
+public:
+    inline ProfileScope( Profiler& pProfiler, Profiler::Phase pPhase, unsigned long pCount );
+    inline ~ProfileScope();
+
+protected:
+    Profiler& mProfiler;
+    Profiler::Phase mPhase;
+    unsigned long mCount;
+    std::chrono::steady_clock::time_point mStart;
+};
+
+#pragma mark Profiler Implementation
+
+void
+Profiler::add( Phase pPhase, double pTimeNs, unsigned long pCount )
+{
+    mStepTimes[pPhase] += pTimeNs;
+    mStepCounts[pPhase] += pCount;
+}
+
+#pragma mark ProfileScope Implementation
+
+ProfileScope::ProfileScope( Profiler& pProfiler, Profiler::Phase pPhase, unsigned long pCount )
+: mProfiler( pProfiler )
+, mPhase( pPhase )
+, mCount( pCount )
+, mStart( std::chrono::steady_clock::now() )
+{}
+
+ProfileScope::~ProfileScope()
+{
+    mProfiler.add( mPhase, std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - mStart ).count(), mCount );
+}
+
+};
+
+};
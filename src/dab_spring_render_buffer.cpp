@@ -0,0 +1,7 @@
+/** \file dab_spring_render_buffer.cpp
+*/
+
+#include "dab_spring_render_buffer.h"
+
+using namespace dab;
+using namespace dab::spring;
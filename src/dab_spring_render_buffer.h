@@ -0,0 +1,184 @@
+/** \file dab_spring_render_buffer.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <Eigen/Dense>
+#include "dab_spring_mass_point.h"
+#include "dab_spring_spring.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark RenderBuffer Definition
+
+// contiguous float buffers of the simulation geometry that can be uploaded to vertex buffers as they are
+// positions holds Dim floats per mass point in the order of the simulation's mass points
+// segments holds 2 * Dim floats per spring, the positions of its first and second mass point
+// indices holds 2 indices per spring into positions, it only changes when the build count changes
+// the buffers are built once for a set of springs and mass points and refreshed in place every step
+
+template< unsigned int Dim >
+class RenderBuffer
+{
+public:
+    RenderBuffer();
+    ~RenderBuffer();
+
+    unsigned int pointCount() const;
+    unsigned int segmentCount() const;
+    unsigned long buildCount() const;
+
+    const std::vector< float >& positions() const;
+    const std::vector< float >& segments() const;
+    const std::vector< unsigned int >& indices() const;
+
+    void build( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings );
+    void refresh();
+    void clear();
+
+protected:
+    std::vector< MassPoint<Dim>* > mMassPoints;
+    std::vector< Spring<Dim>* > mSprings;
+    unsigned long mBuildCount;
+
+    std::vector< float > mPositions;
+    std::vector< float > mSegments;
+    std::vector< unsigned int > mIndices;
+};
+
+#pragma mark RenderBuffer Implementation
+
+template< unsigned int Dim >
+RenderBuffer<Dim>::RenderBuffer()
+: mBuildCount( 0 )
+{}
+
+template< unsigned int Dim >
+RenderBuffer<Dim>::~RenderBuffer()
+{}
+
+template< unsigned int Dim >
+unsigned int
+RenderBuffer<Dim>::pointCount() const
+{
+    return mMassPoints.size();
+}
+
+template< unsigned int Dim >
+unsigned int
+RenderBuffer<Dim>::segmentCount() const
+{
+    return mSprings.size();
+}
+
+template< unsigned int Dim >
+unsigned long
+RenderBuffer<Dim>::buildCount() const
+{
+    return mBuildCount;
+}
+
+template< unsigned int Dim >
+const std::vector< float >&
+RenderBuffer<Dim>::positions() const
+{
+    return mPositions;
+}
+
+template< unsigned int Dim >
+const std::vector< float >&
+RenderBuffer<Dim>::segments() const
+{
+    return mSegments;
+}
+
+template< unsigned int Dim >
+const std::vector< unsigned int >&
+RenderBuffer<Dim>::indices() const
+{
+    return mIndices;
+}
+
+template< unsigned int Dim >
+void
+RenderBuffer<Dim>::build( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings )
+{
+    mMassPoints = pMassPoints;
+    mSprings = pSprings;
+
+    int massCount = mMassPoints.size();
+    int springCount = mSprings.size();
+
+    std::unordered_map< const MassPoint<Dim>*, unsigned int > massIndices;
+    massIndices.reserve( massCount );
+    for(int pI=0; pI<massCount; ++pI) massIndices[ mMassPoints[pI] ] = pI;
+
+    mPositions.resize( massCount * Dim );
+    mSegments.resize( springCount * 2 * Dim );
+    mIndices.resize( springCount * 2 );
+
+    for(int sI=0; sI<springCount; ++sI)
+    {
+        mIndices[ sI * 2 ] = massIndices[ mSprings[sI]->massPoint1() ];
+        mIndices[ sI * 2 + 1 ] = massIndices[ mSprings[sI]->massPoint2() ];
+    }
+
+    mBuildCount++;
+
+    refresh();
+}
+
+template< unsigned int Dim >
+void
+RenderBuffer<Dim>::refresh()
+{
+    int massCount = mMassPoints.size();
+    int springCount = mSprings.size();
+
+    float* position = mPositions.data();
+
+    for(int pI=0; pI<massCount; ++pI, position += Dim)
+    {
+        const Eigen::Matrix<float, Dim, 1>& mpPosition = mMassPoints[pI]->position();
+        for(unsigned int d=0; d<Dim; ++d) position[d] = mpPosition[d];
+    }
+
+    // segment end points are copied from the position buffer instead of being read from the mass points again
+    const unsigned int* index = mIndices.data();
+    float* segment = mSegments.data();
+
+    for(int sI=0; sI<springCount; ++sI, index += 2, segment += 2 * Dim)
+    {
+        const float* position1 = mPositions.data() + index[0] * Dim;
+        const float* position2 = mPositions.data() + index[1] * Dim;
+
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            segment[d] = position1[d];
+            segment[Dim + d] = position2[d];
+        }
+    }
+}
+
+template< unsigned int Dim >
+void
+RenderBuffer<Dim>::clear()
+{
+    mMassPoints.clear();
+    mSprings.clear();
+    mPositions.clear();
+    mSegments.clear();
+    mIndices.clear();
+    mBuildCount++;
+}
+
+};
+
+};
@@ -0,0 +1,7 @@
+/** \file dab_spring_scene_loader.cpp
+*/
+
+#include "dab_spring_scene_loader.h"
+
+using namespace dab;
+using namespace dab::spring;
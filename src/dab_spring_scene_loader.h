@@ -0,0 +1,389 @@
+/** \file dab_spring_scene_loader.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <unordered_map>
+#include <Eigen/Dense>
+#include "dab_spring_simulation.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark SceneLoader Definition
+
+// streaming loader for text scene descriptions, one statement per line, # starts a comment
+//
+// count <pointCount> <springCount>                   optional, reserves space for large scenes
+// gravity <x> <y> [<z>]
+// damping <value>
+// timestep <value>
+// material <name> <stiffness> <damping> [<angleStiffness>]
+// point <mass> <x> <y> [<z>] [<vx> <vy> [<vz>]]      points are indexed from 0 in the order they appear
+// spring <point1> <point2> <material> [<restLength>]
+// angled <point1> <point2> <material> <restAngle1> [<restAngle2>]
+// dir <point1> <point2> <material> <dirX> <dirY> [<dirZ>]
+//
+// springs start at rest unless a rest length is given, angled and dir springs use the angle stiffness of their material
+// statements are applied while reading, points and springs are added to the simulation right away
+// point indices refer to the points of the current load, points and springs of earlier loads are kept
+// on a parse error the points and springs of the current load are removed from the simulation and deleted, parameters that were already set remain
+// mass points and springs are owned by the loader and have to outlive their use in the simulation
+
+template< unsigned int Dim >
+class SceneLoader
+{
+public:
+    SceneLoader();
+    ~SceneLoader();
+
+    const std::vector< MassPoint<Dim>* >& massPoints() const;
+    const std::vector< Spring<Dim>* >& springs() const;
+
+    bool load( const std::string& pFileName, Simulation<Dim>& pSimulation );
+    bool load( std::istream& pStream, Simulation<Dim>& pSimulation );
+    void clear();
+
+protected:
+    enum SpringType
+    {
+        PlainSpring,
+        AngledSpringType,
+        DirSpringType
+    };
+
+    struct Material
+    {
+        float mStiffness;
+        float mDamping;
+        float mAngleStiffness;
+    };
+
+    std::vector< MassPoint<Dim>* > mMassPoints;
+    std::vector< Spring<Dim>* > mSprings;
+    std::vector< SpringType > mSpringTypes;
+    std::unordered_map< std::string, Material > mMaterials;
+
+    const char* mCursor;
+    unsigned int mLineNumber;
+    unsigned int mPointOffset;
+
+    inline bool nextToken( const char*& pToken, size_t& pLength );
+    inline bool nextFloat( float& pValue );
+    inline bool nextIndex( unsigned int& pValue );
+    bool parseLine( const char* pLine, Simulation<Dim>& pSimulation );
+    bool parseSpring( SpringType pType, Simulation<Dim>& pSimulation );
+    void rollback( unsigned int pPointOffset, unsigned int pSpringOffset, Simulation<Dim>& pSimulation );
+    bool error( const std::string& pMessage ) const;
+};
+
+typedef SceneLoader<2>  SceneLoader2D;
+typedef SceneLoader<3>  SceneLoader3D;
+
+#pragma mark SceneLoader Implementation
+
+template< unsigned int Dim >
+SceneLoader<Dim>::SceneLoader()
+: mCursor( nullptr )
+, mLineNumber( 0 )
+, mPointOffset( 0 )
+{}
+
+template< unsigned int Dim >
+SceneLoader<Dim>::~SceneLoader()
+{
+    clear();
+}
+
+template< unsigned int Dim >
+const std::vector< MassPoint<Dim>* >&
+SceneLoader<Dim>::massPoints() const
+{
+    return mMassPoints;
+}
+
+template< unsigned int Dim >
+const std::vector< Spring<Dim>* >&
+SceneLoader<Dim>::springs() const
+{
+    return mSprings;
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::load( const std::string& pFileName, Simulation<Dim>& pSimulation )
+{
+    std::ifstream file( pFileName );
+
+    if( file.is_open() == false )
+    {
+        std::cout << "SceneLoader: could not open " << pFileName << "\n";
+        return false;
+    }
+
+    return load( file, pSimulation );
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::load( std::istream& pStream, Simulation<Dim>& pSimulation )
+{
+    // only the current line is held in memory, the line buffer is reused
+
+    std::string line;
+    mLineNumber = 0;
+    mPointOffset = mMassPoints.size();
+
+    unsigned int springOffset = mSprings.size();
+
+    while( std::getline( pStream, line ) )
+    {
+        mLineNumber++;
+
+        if( parseLine( line.c_str(), pSimulation ) == false )
+        {
+            rollback( mPointOffset, springOffset, pSimulation );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template< unsigned int Dim >
+void
+SceneLoader<Dim>::clear()
+{
+    deleteSprings( mMassPoints, mSprings );
+
+    mMassPoints.clear();
+    mSprings.clear();
+    mSpringTypes.clear();
+    mMaterials.clear();
+    mPointOffset = 0;
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::nextToken( const char*& pToken, size_t& pLength )
+{
+    while( *mCursor == ' ' || *mCursor == '\t' || *mCursor == '\r' ) mCursor++;
+    if( *mCursor == '\0' || *mCursor == '#' ) return false;
+
+    pToken = mCursor;
+    while( *mCursor != '\0' && *mCursor != ' ' && *mCursor != '\t' && *mCursor != '\r' && *mCursor != '#' ) mCursor++;
+    pLength = mCursor - pToken;
+
+    return true;
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::nextFloat( float& pValue )
+{
+    char* end;
+    pValue = std::strtof( mCursor, &end );
+    if( end == mCursor ) return false;
+
+    mCursor = end;
+    return true;
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::nextIndex( unsigned int& pValue )
+{
+    char* end;
+    pValue = std::strtoul( mCursor, &end, 10 );
+    if( end == mCursor ) return false;
+
+    mCursor = end;
+    return true;
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::parseLine( const char* pLine, Simulation<Dim>& pSimulation )
+{
+    mCursor = pLine;
+
+    const char* token;
+    size_t length;
+
+    if( nextToken( token, length ) == false ) return true;
+
+    std::string keyword( token, length );
+
+    if( keyword == "point" )
+    {
+        float mass;
+        Eigen::Matrix<float, Dim, 1> position;
+        Eigen::Matrix<float, Dim, 1> velocity;
+
+        if( nextFloat( mass ) == false ) return error( "point without mass" );
+        for(unsigned int d=0; d<Dim; ++d) if( nextFloat( position[d] ) == false ) return error( "point with less than " + std::to_string( Dim ) + " coordinates" );
+
+        MassPoint<Dim>* massPoint = new MassPoint<Dim>( mass, position );
+        mMassPoints.push_back( massPoint );
+
+        if( nextFloat( velocity[0] ) )
+        {
+            for(unsigned int d=1; d<Dim; ++d) if( nextFloat( velocity[d] ) == false ) return error( "point with less than " + std::to_string( Dim ) + " velocity components" );
+            massPoint->setVelocity( velocity );
+        }
+
+        pSimulation.addMassPoint( massPoint );
+    }
+    else if( keyword == "spring" ) return parseSpring( PlainSpring, pSimulation );
+    else if( keyword == "angled" ) return parseSpring( AngledSpringType, pSimulation );
+    else if( keyword == "dir" ) return parseSpring( DirSpringType, pSimulation );
+    else if( keyword == "material" )
+    {
+        Material material = { 0.0, 0.0, 0.0 };
+
+        if( nextToken( token, length ) == false ) return error( "material without name" );
+        std::string name( token, length );
+
+        if( nextFloat( material.mStiffness ) == false || nextFloat( material.mDamping ) == false ) return error( "material " + name + " without stiffness and damping" );
+        nextFloat( material.mAngleStiffness );
+
+        mMaterials[name] = material;
+    }
+    else if( keyword == "count" )
+    {
+        unsigned int pointCount;
+        unsigned int springCount;
+
+        if( nextIndex( pointCount ) == false || nextIndex( springCount ) == false ) return error( "count without point and spring count" );
+
+        mMassPoints.reserve( mMassPoints.size() + pointCount );
+        mSprings.reserve( mSprings.size() + springCount );
+        mSpringTypes.reserve( mSpringTypes.size() + springCount );
+        pSimulation.reserve( pSimulation.massPoints().size() + pointCount, pSimulation.springs().size() + springCount );
+    }
+    else if( keyword == "gravity" )
+    {
+        Eigen::Matrix<float, Dim, 1> gravity;
+        for(unsigned int d=0; d<Dim; ++d) if( nextFloat( gravity[d] ) == false ) return error( "gravity with less than " + std::to_string( Dim ) + " components" );
+
+        pSimulation.setGravity( gravity );
+    }
+    else if( keyword == "damping" )
+    {
+        float damping;
+        if( nextFloat( damping ) == false ) return error( "damping without value" );
+
+        pSimulation.setDamping( damping );
+    }
+    else if( keyword == "timestep" )
+    {
+        float timeStep;
+        if( nextFloat( timeStep ) == false ) return error( "timestep without value" );
+
+        pSimulation.setTimeStep( timeStep );
+    }
+    else
+    {
+        return error( "unknown statement " + keyword );
+    }
+
+    return true;
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::parseSpring( SpringType pType, Simulation<Dim>& pSimulation )
+{
+    unsigned int index1;
+    unsigned int index2;
+    const char* token;
+    size_t length;
+
+    if( nextIndex( index1 ) == false || nextIndex( index2 ) == false ) return error( "spring without two point indices" );
+    if( index1 >= mMassPoints.size() - mPointOffset || index2 >= mMassPoints.size() - mPointOffset ) return error( "spring point index out of range" );
+    if( nextToken( token, length ) == false ) return error( "spring without material" );
+
+    auto materialIter = mMaterials.find( std::string( token, length ) );
+    if( materialIter == mMaterials.end() ) return error( "unknown material " + std::string( token, length ) );
+
+    const Material& material = materialIter->second;
+    MassPoint<Dim>* mass1 = mMassPoints[mPointOffset + index1];
+    MassPoint<Dim>* mass2 = mMassPoints[mPointOffset + index2];
+    float restLength = ( mass2->position() - mass1->position() ).norm();
+
+    // the base spring constructor can not update the angles and reference frames of derived springs
+    if( pType == AngledSpringType )
+    {
+        float restAngle1;
+        float restAngle2 = 0.0;
+
+        if( nextFloat( restAngle1 ) == false ) return error( "angled spring without rest angle" );
+        nextFloat( restAngle2 );
+
+        AngledSpring<Dim>* spring = new AngledSpring<Dim>( mass1, mass2, restLength, material.mStiffness, restAngle1, restAngle2, material.mAngleStiffness, material.mDamping );
+        spring->update();
+        mSprings.push_back( spring );
+        mSpringTypes.push_back( pType );
+        pSimulation.addSpring( spring );
+    }
+    else if( pType == DirSpringType )
+    {
+        Eigen::Matrix<float, Dim, 1> restDir;
+        for(unsigned int d=0; d<Dim; ++d) if( nextFloat( restDir[d] ) == false ) return error( "dir spring with less than " + std::to_string( Dim ) + " direction components" );
+
+        DirSpring<Dim>* spring = new DirSpring<Dim>( mass1, mass2, restLength, material.mStiffness, restDir, material.mAngleStiffness, material.mDamping );
+        spring->update();
+        mSprings.push_back( spring );
+        mSpringTypes.push_back( pType );
+        pSimulation.addSpring( spring );
+    }
+    else
+    {
+        nextFloat( restLength );
+
+        Spring<Dim>* spring = new Spring<Dim>( mass1, mass2, restLength, material.mStiffness, material.mDamping );
+        mSprings.push_back( spring );
+        mSpringTypes.push_back( pType );
+        pSimulation.addSpring( spring );
+    }
+
+    return true;
+}
+
+template< unsigned int Dim >
+void
+SceneLoader<Dim>::rollback( unsigned int pPointOffset, unsigned int pSpringOffset, Simulation<Dim>& pSimulation )
+{
+    // springs and mass points of the failed load are removed in bulk, one at a time would be quadratic in their number
+    std::vector< MassPoint<Dim>* > massPoints( mMassPoints.begin() + pPointOffset, mMassPoints.end() );
+    std::vector< Spring<Dim>* > springs( mSprings.begin() + pSpringOffset, mSprings.end() );
+
+    pSimulation.removeSprings( springs, massPoints );
+
+    deleteSprings( massPoints, springs );
+
+    mMassPoints.resize( pPointOffset );
+    mSprings.resize( pSpringOffset );
+    mSpringTypes.resize( pSpringOffset );
+}
+
+template< unsigned int Dim >
+bool
+SceneLoader<Dim>::error( const std::string& pMessage ) const
+{
+    std::cout << "SceneLoader: line " << mLineNumber << ": " << pMessage << "\n";
+    return false;
+}
+
+};
+
+};
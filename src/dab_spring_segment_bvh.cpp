@@ -0,0 +1,7 @@
+/** \file dab_spring_segment_bvh.cpp
+*/
+
+#include "dab_spring_segment_bvh.h"
+
+using namespace dab;
+using namespace dab::spring;
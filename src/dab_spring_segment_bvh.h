@@ -0,0 +1,354 @@
+/** \file dab_spring_segment_bvh.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <Eigen/Dense>
+#include "dab_spring_mass_point.h"
+#include "dab_spring_spring.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark SegmentBVH Definition
+
+// bounding volume hierarchy of axis aligned boxes over spring segments
+// the hierarchy is built once for a set of springs and refit to the current spring geometry every step
+
+template< unsigned int Dim >
+class SegmentBVH
+{
+public:
+    SegmentBVH();
+    ~SegmentBVH();
+
+    const std::vector< Spring<Dim>* >& springs() const;
+
+    void build( const std::vector< Spring<Dim>* >& pSprings, float pMargin );
+    void refit( float pMargin );
+    template< class Callback > void pairs( Callback& pCallback ) const;
+
+    static inline void closestPoints( const Eigen::Matrix<float, Dim, 1>& pStart1, const Eigen::Matrix<float, Dim, 1>& pEnd1, const Eigen::Matrix<float, Dim, 1>& pStart2, const Eigen::Matrix<float, Dim, 1>& pEnd2, float& pParameter1, float& pParameter2 );
+
+protected:
+    struct Node
+    {
+        Node()
+        : mMin( Eigen::Matrix<float, Dim, 1>::Constant( 0.0 ) )
+        , mMax( Eigen::Matrix<float, Dim, 1>::Constant( 0.0 ) )
+        , mLeft( -1 )
+        , mRight( -1 )
+        , mStart( 0 )
+        , mCount( 0 )
+        {}
+
+        Eigen::Matrix<float, Dim, 1> mMin;
+        Eigen::Matrix<float, Dim, 1> mMax;
+        int mLeft; // child indices for inner nodes, -1 for leaves
+        int mRight;
+        int mStart; // segment range for leaves
+        int mCount;
+    };
+
+    static const int sLeafSize = 4;
+
+    std::vector< Spring<Dim>* > mSprings;
+    std::vector< Node > mNodes;
+
+    int buildNode( int pStart, int pCount, std::vector< Eigen::Matrix<float, Dim, 1> >& pCentroids );
+    void segmentBounds( const Spring<Dim>* pSpring, float pMargin, Eigen::Matrix<float, Dim, 1>& pMin, Eigen::Matrix<float, Dim, 1>& pMax ) const;
+    inline bool overlap( const Node& pNode1, const Node& pNode2 ) const;
+    inline bool adjacent( const Spring<Dim>* pSpring1, const Spring<Dim>* pSpring2 ) const;
+    template< class Callback > void leafPairs( const Node& pNode1, const Node& pNode2, Callback& pCallback ) const;
+};
+
+#pragma mark SegmentBVH Implementation
+
+template< unsigned int Dim >
+SegmentBVH<Dim>::SegmentBVH()
+{}
+
+template< unsigned int Dim >
+SegmentBVH<Dim>::~SegmentBVH()
+{}
+
+template< unsigned int Dim >
+const std::vector< Spring<Dim>* >&
+SegmentBVH<Dim>::springs() const
+{
+    return mSprings;
+}
+
+template< unsigned int Dim >
+void
+SegmentBVH<Dim>::build( const std::vector< Spring<Dim>* >& pSprings, float pMargin )
+{
+    mSprings = pSprings;
+    mNodes.clear();
+
+    int springCount = mSprings.size();
+    if( springCount == 0 ) return;
+
+    mNodes.reserve( 2 * springCount / sLeafSize + 1 );
+
+    std::vector< Eigen::Matrix<float, Dim, 1> > centroids( springCount );
+    for(int sI=0; sI<springCount; ++sI) centroids[sI] = ( mSprings[sI]->massPoint1()->position() + mSprings[sI]->massPoint2()->position() ) * 0.5;
+
+    buildNode( 0, springCount, centroids );
+    refit( pMargin );
+}
+
+template< unsigned int Dim >
+int
+SegmentBVH<Dim>::buildNode( int pStart, int pCount, std::vector< Eigen::Matrix<float, Dim, 1> >& pCentroids )
+{
+    // children are always stored after their parent, refit can therefore process the nodes in reverse order
+
+    int nodeIndex = mNodes.size();
+    mNodes.push_back( Node() );
+
+    Node& node = mNodes[nodeIndex];
+    node.mLeft = -1;
+    node.mRight = -1;
+    node.mStart = pStart;
+    node.mCount = pCount;
+
+    if( pCount <= sLeafSize ) return nodeIndex;
+
+    // median split along the axis of largest centroid extent
+    Eigen::Matrix<float, Dim, 1> centroidMin = pCentroids[pStart];
+    Eigen::Matrix<float, Dim, 1> centroidMax = pCentroids[pStart];
+
+    for(int sI=pStart+1; sI<pStart+pCount; ++sI)
+    {
+        centroidMin = centroidMin.cwiseMin( pCentroids[sI] );
+        centroidMax = centroidMax.cwiseMax( pCentroids[sI] );
+    }
+
+    int axis;
+    ( centroidMax - centroidMin ).maxCoeff( &axis );
+
+    int half = pCount / 2;
+
+    std::vector< int > order( pCount );
+    for(int i=0; i<pCount; ++i) order[i] = pStart + i;
+    std::nth_element( order.begin(), order.begin() + half, order.end(), [&pCentroids, axis]( int pIndex1, int pIndex2 ) { return pCentroids[pIndex1][axis] < pCentroids[pIndex2][axis]; } );
+
+    std::vector< Spring<Dim>* > sortedSprings( pCount );
+    std::vector< Eigen::Matrix<float, Dim, 1> > sortedCentroids( pCount );
+    for(int i=0; i<pCount; ++i)
+    {
+        sortedSprings[i] = mSprings[ order[i] ];
+        sortedCentroids[i] = pCentroids[ order[i] ];
+    }
+    std::copy( sortedSprings.begin(), sortedSprings.end(), mSprings.begin() + pStart );
+    std::copy( sortedCentroids.begin(), sortedCentroids.end(), pCentroids.begin() + pStart );
+
+    int left = buildNode( pStart, half, pCentroids );
+    int right = buildNode( pStart + half, pCount - half, pCentroids );
+
+    // mNodes may have been reallocated by the recursive calls
+    mNodes[nodeIndex].mLeft = left;
+    mNodes[nodeIndex].mRight = right;
+
+    return nodeIndex;
+}
+
+template< unsigned int Dim >
+void
+SegmentBVH<Dim>::segmentBounds( const Spring<Dim>* pSpring, float pMargin, Eigen::Matrix<float, Dim, 1>& pMin, Eigen::Matrix<float, Dim, 1>& pMax ) const
+{
+    const Eigen::Matrix<float, Dim, 1>& start = pSpring->massPoint1()->position();
+    Eigen::Matrix<float, Dim, 1> end = start + pSpring->direction() * pSpring->length();
+
+    pMin = start.cwiseMin( end ).array() - pMargin;
+    pMax = start.cwiseMax( end ).array() + pMargin;
+}
+
+template< unsigned int Dim >
+void
+SegmentBVH<Dim>::refit( float pMargin )
+{
+    int nodeCount = mNodes.size();
+
+    Eigen::Matrix<float, Dim, 1> segmentMin;
+    Eigen::Matrix<float, Dim, 1> segmentMax;
+
+    for(int nI=nodeCount-1; nI>=0; --nI)
+    {
+        Node& node = mNodes[nI];
+
+        if( node.mLeft < 0 )
+        {
+            segmentBounds( mSprings[node.mStart], pMargin, node.mMin, node.mMax );
+
+            for(int sI=node.mStart+1; sI<node.mStart+node.mCount; ++sI)
+            {
+                segmentBounds( mSprings[sI], pMargin, segmentMin, segmentMax );
+                node.mMin = node.mMin.cwiseMin( segmentMin );
+                node.mMax = node.mMax.cwiseMax( segmentMax );
+            }
+        }
+        else
+        {
+            node.mMin = mNodes[node.mLeft].mMin.cwiseMin( mNodes[node.mRight].mMin );
+            node.mMax = mNodes[node.mLeft].mMax.cwiseMax( mNodes[node.mRight].mMax );
+        }
+    }
+}
+
+template< unsigned int Dim >
+bool
+SegmentBVH<Dim>::overlap( const Node& pNode1, const Node& pNode2 ) const
+{
+    return ( pNode1.mMin.array() <= pNode2.mMax.array() ).all() && ( pNode2.mMin.array() <= pNode1.mMax.array() ).all();
+}
+
+template< unsigned int Dim >
+bool
+SegmentBVH<Dim>::adjacent( const Spring<Dim>* pSpring1, const Spring<Dim>* pSpring2 ) const
+{
+    return pSpring1->massPoint1() == pSpring2->massPoint1() || pSpring1->massPoint1() == pSpring2->massPoint2() || pSpring1->massPoint2() == pSpring2->massPoint1() || pSpring1->massPoint2() == pSpring2->massPoint2();
+}
+
+template< unsigned int Dim >
+template< class Callback >
+void
+SegmentBVH<Dim>::pairs( Callback& pCallback ) const
+{
+    // calls pCallback( spring1, spring2 ) once for each pair of non adjacent springs whose bounds overlap
+
+    if( mNodes.size() == 0 ) return;
+
+    std::vector< std::pair<int, int> > stack;
+    stack.push_back( std::make_pair( 0, 0 ) );
+
+    while( stack.size() > 0 )
+    {
+        std::pair<int, int> nodePair = stack.back();
+        stack.pop_back();
+
+        const Node& node1 = mNodes[nodePair.first];
+        const Node& node2 = mNodes[nodePair.second];
+
+        if( nodePair.first == nodePair.second )
+        {
+            if( node1.mLeft < 0 )
+            {
+                leafPairs( node1, node1, pCallback );
+            }
+            else
+            {
+                stack.push_back( std::make_pair( node1.mLeft, node1.mLeft ) );
+                stack.push_back( std::make_pair( node1.mRight, node1.mRight ) );
+                stack.push_back( std::make_pair( node1.mLeft, node1.mRight ) );
+            }
+
+            continue;
+        }
+
+        if( overlap( node1, node2 ) == false ) continue;
+
+        if( node1.mLeft < 0 && node2.mLeft < 0 )
+        {
+            leafPairs( node1, node2, pCallback );
+        }
+        else if( node2.mLeft < 0 || ( node1.mLeft >= 0 && node1.mCount >= node2.mCount ) )
+        {
+            stack.push_back( std::make_pair( node1.mLeft, nodePair.second ) );
+            stack.push_back( std::make_pair( node1.mRight, nodePair.second ) );
+        }
+        else
+        {
+            stack.push_back( std::make_pair( nodePair.first, node2.mLeft ) );
+            stack.push_back( std::make_pair( nodePair.first, node2.mRight ) );
+        }
+    }
+}
+
+template< unsigned int Dim >
+template< class Callback >
+void
+SegmentBVH<Dim>::leafPairs( const Node& pNode1, const Node& pNode2, Callback& pCallback ) const
+{
+    bool sameNode = &pNode1 == &pNode2;
+
+    for(int sI=pNode1.mStart; sI<pNode1.mStart+pNode1.mCount; ++sI)
+    {
+        int startIndex = sameNode ? sI + 1 : pNode2.mStart;
+
+        for(int sJ=startIndex; sJ<pNode2.mStart+pNode2.mCount; ++sJ)
+        {
+            if( adjacent( mSprings[sI], mSprings[sJ] ) ) continue;
+
+            pCallback( mSprings[sI], mSprings[sJ] );
+        }
+    }
+}
+
+template< unsigned int Dim >
+void
+SegmentBVH<Dim>::closestPoints( const Eigen::Matrix<float, Dim, 1>& pStart1, const Eigen::Matrix<float, Dim, 1>& pEnd1, const Eigen::Matrix<float, Dim, 1>& pStart2, const Eigen::Matrix<float, Dim, 1>& pEnd2, float& pParameter1, float& pParameter2 )
+{
+    // closest points between two segments (Ericson, Real-Time Collision Detection, 5.1.9)
+
+    Eigen::Matrix<float, Dim, 1> dir1 = pEnd1 - pStart1;
+    Eigen::Matrix<float, Dim, 1> dir2 = pEnd2 - pStart2;
+    Eigen::Matrix<float, Dim, 1> offset = pStart1 - pStart2;
+
+    float a = dir1.squaredNorm();
+    float e = dir2.squaredNorm();
+    float f = dir2.dot( offset );
+
+    const float epsilon = 1e-8;
+
+    if( a <= epsilon && e <= epsilon )
+    {
+        pParameter1 = 0.0;
+        pParameter2 = 0.0;
+        return;
+    }
+
+    if( a <= epsilon )
+    {
+        pParameter1 = 0.0;
+        pParameter2 = std::min( std::max( f / e, 0.0f ), 1.0f );
+        return;
+    }
+
+    float c = dir1.dot( offset );
+
+    if( e <= epsilon )
+    {
+        pParameter2 = 0.0;
+        pParameter1 = std::min( std::max( -c / a, 0.0f ), 1.0f );
+        return;
+    }
+
+    float b = dir1.dot( dir2 );
+    float denom = a * e - b * b;
+
+    pParameter1 = denom > epsilon ? std::min( std::max( ( b * f - c * e ) / denom, 0.0f ), 1.0f ) : 0.0f;
+    pParameter2 = ( b * pParameter1 + f ) / e;
+
+    if( pParameter2 < 0.0 )
+    {
+        pParameter2 = 0.0;
+        pParameter1 = std::min( std::max( -c / a, 0.0f ), 1.0f );
+    }
+    else if( pParameter2 > 1.0 )
+    {
+        pParameter2 = 1.0;
+        pParameter1 = std::min( std::max( ( b - c ) / a, 0.0f ), 1.0f );
+    }
+}
+
+};
+
+};
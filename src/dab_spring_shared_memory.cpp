@@ -0,0 +1,7 @@
+/** \file dab_spring_shared_memory.cpp
+*/
+
+#include "dab_spring_shared_memory.h"
+
+using namespace dab;
+using namespace dab::spring;
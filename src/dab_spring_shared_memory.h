@@ -0,0 +1,497 @@
+/** \file dab_spring_shared_memory.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <Eigen/Dense>
+#include "dab_spring_simulation.h"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define DAB_SPRING_SHARED_MEMORY
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark SharedMemory Definition
+
+// layout of the shared memory segment
+// header, followed by a ring of slots, each slot holds one published frame
+// a slot starts with a seqlock sequence that is odd while the publisher writes the slot
+// followed by Dim floats per mass point and 3 floats per selected spring (length, strain, tension)
+// readers check the sequence before and after accessing a slot and retry if it changed
+// the sequence and frame counters are lock free atomics that are shared between processes
+
+struct SharedMemory
+{
+    static const uint32_t sVersion = 1;
+    static const uint32_t sSpringMetricCount = 3;
+    static const size_t sAlignment = 64;
+
+    struct Header
+    {
+        char mMagic[4];
+        uint32_t mVersion;
+        uint32_t mDim;
+        uint32_t mSlotCount;
+        uint32_t mMaxPoints;
+        uint32_t mMaxSprings;
+        uint64_t mSlotSize;
+        std::atomic< uint64_t > mFrameCount;
+    };
+
+    struct SlotHeader
+    {
+        std::atomic< uint64_t > mSequence;
+        uint64_t mSimStep;
+        uint32_t mPointCount;
+        uint32_t mSpringCount;
+    };
+
+    struct Frame
+    {
+        uint64_t mFrame;
+        uint64_t mSimStep;
+        unsigned int mPointCount;
+        unsigned int mSpringCount;
+        const float* mPositions;
+        const float* mSpringMetrics;
+    };
+
+    static inline size_t align( size_t pSize )
+    {
+        return ( pSize + sAlignment - 1 ) / sAlignment * sAlignment;
+    }
+
+    static inline size_t slotSize( unsigned int pDim, unsigned int pMaxPoints, unsigned int pMaxSprings )
+    {
+        return align( align( sizeof( SlotHeader ) ) + ( pMaxPoints * pDim + pMaxSprings * sSpringMetricCount ) * sizeof( float ) );
+    }
+
+    static inline std::string segmentName( const std::string& pName )
+    {
+        return pName.size() > 0 && pName[0] == '/' ? pName : "/" + pName;
+    }
+};
+
+#pragma mark SharedMemoryPublisher Definition
+
+// publishes the mass point positions and the metrics of selected springs into a named shared memory segment
+// publish() writes into the next slot of the ring without any system call, mass points and springs beyond the
+// capacity given to open() are not published
+// the segment is removed when the publisher is closed
+
+template< unsigned int Dim >
+class SharedMemoryPublisher
+{
+public:
+    SharedMemoryPublisher();
+    ~SharedMemoryPublisher();
+
+    bool isOpen() const;
+    uint64_t frameCount() const;
+    const std::vector< Spring<Dim>* >& springs() const;
+
+    bool open( const std::string& pName, unsigned int pMaxPoints, unsigned int pMaxSprings = 0, unsigned int pSlotCount = 4 );
+    void setSprings( const std::vector< Spring<Dim>* >& pSprings );
+    void publish( const Simulation<Dim>& pSimulation );
+    void close();
+
+protected:
+    std::string mName;
+    uint8_t* mMemory;
+    size_t mSize;
+    SharedMemory::Header* mHeader;
+    uint64_t mFrameCount;
+    std::vector< Spring<Dim>* > mSprings;
+};
+
+typedef SharedMemoryPublisher<2>  SharedMemoryPublisher2D;
+typedef SharedMemoryPublisher<3>  SharedMemoryPublisher3D;
+
+#pragma mark SharedMemoryReader Definition
+
+// maps a segment created by a publisher read only
+// read() hands the latest frame to a callback that accesses the shared memory directly
+// the callback can see a partially overwritten frame, read() only returns true if the frame stayed intact,
+// values computed by the callback must be discarded otherwise
+
+template< unsigned int Dim >
+class SharedMemoryReader
+{
+public:
+    SharedMemoryReader();
+    ~SharedMemoryReader();
+
+    bool isOpen() const;
+    unsigned int maxPoints() const;
+    unsigned int maxSprings() const;
+    uint64_t latestFrame() const;
+
+    bool open( const std::string& pName );
+    template< class Callback > bool read( Callback& pCallback, unsigned int pRetryCount = 8 ) const;
+    void close();
+
+protected:
+    const uint8_t* mMemory;
+    size_t mSize;
+    const SharedMemory::Header* mHeader;
+};
+
+typedef SharedMemoryReader<2>  SharedMemoryReader2D;
+typedef SharedMemoryReader<3>  SharedMemoryReader3D;
+
+#pragma mark SharedMemoryPublisher Implementation
+
+template< unsigned int Dim >
+SharedMemoryPublisher<Dim>::SharedMemoryPublisher()
+: mMemory( nullptr )
+, mSize( 0 )
+, mHeader( nullptr )
+, mFrameCount( 0 )
+{}
+
+template< unsigned int Dim >
+SharedMemoryPublisher<Dim>::~SharedMemoryPublisher()
+{
+    close();
+}
+
+template< unsigned int Dim >
+bool
+SharedMemoryPublisher<Dim>::isOpen() const
+{
+    return mMemory != nullptr;
+}
+
+template< unsigned int Dim >
+uint64_t
+SharedMemoryPublisher<Dim>::frameCount() const
+{
+    return mFrameCount;
+}
+
+template< unsigned int Dim >
+const std::vector< Spring<Dim>* >&
+SharedMemoryPublisher<Dim>::springs() const
+{
+    return mSprings;
+}
+
+template< unsigned int Dim >
+bool
+SharedMemoryPublisher<Dim>::open( const std::string& pName, unsigned int pMaxPoints, unsigned int pMaxSprings, unsigned int pSlotCount )
+{
+    close();
+
+#ifdef DAB_SPRING_SHARED_MEMORY
+    if( pSlotCount < 2 )
+    {
+        std::cout << "SharedMemoryPublisher: at least two slots are required\n";
+        return false;
+    }
+
+    std::string name = SharedMemory::segmentName( pName );
+    size_t slotSize = SharedMemory::slotSize( Dim, pMaxPoints, pMaxSprings );
+    size_t size = SharedMemory::align( sizeof( SharedMemory::Header ) ) + slotSize * pSlotCount;
+
+    int fd = shm_open( name.c_str(), O_CREAT | O_RDWR, 0644 );
+
+    if( fd < 0 )
+    {
+        std::cout << "SharedMemoryPublisher: could not open " << name << "\n";
+        return false;
+    }
+
+    if( ftruncate( fd, size ) != 0 )
+    {
+        std::cout << "SharedMemoryPublisher: could not resize " << name << " to " << size << " bytes\n";
+        ::close( fd );
+        shm_unlink( name.c_str() );
+        return false;
+    }
+
+    void* memory = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    ::close( fd );
+
+    if( memory == MAP_FAILED )
+    {
+        std::cout << "SharedMemoryPublisher: could not map " << name << "\n";
+        shm_unlink( name.c_str() );
+        return false;
+    }
+
+    mName = name;
+    mMemory = static_cast< uint8_t* >( memory );
+    mSize = size;
+    mFrameCount = 0;
+
+    // the magic is written last so that readers never accept a half initialized header
+    std::memset( mMemory, 0, mSize );
+
+    mHeader = reinterpret_cast< SharedMemory::Header* >( mMemory );
+    mHeader->mVersion = SharedMemory::sVersion;
+    mHeader->mDim = Dim;
+    mHeader->mSlotCount = pSlotCount;
+    mHeader->mMaxPoints = pMaxPoints;
+    mHeader->mMaxSprings = pMaxSprings;
+    mHeader->mSlotSize = slotSize;
+    mHeader->mFrameCount.store( 0, std::memory_order_relaxed );
+
+    std::atomic_thread_fence( std::memory_order_release );
+    std::memcpy( mHeader->mMagic, "DSSM", 4 );
+
+    if( mSprings.size() > pMaxSprings ) mSprings.resize( pMaxSprings );
+
+    return true;
+#else
+    std::cout << "SharedMemoryPublisher: shared memory is not supported on this platform\n";
+    return false;
+#endif
+}
+
+template< unsigned int Dim >
+void
+SharedMemoryPublisher<Dim>::setSprings( const std::vector< Spring<Dim>* >& pSprings )
+{
+    mSprings = pSprings;
+
+    if( mHeader != nullptr && mSprings.size() > mHeader->mMaxSprings ) mSprings.resize( mHeader->mMaxSprings );
+}
+
+template< unsigned int Dim >
+void
+SharedMemoryPublisher<Dim>::publish( const Simulation<Dim>& pSimulation )
+{
+    if( mMemory == nullptr ) return;
+
+    DAB_SPRING_TRACE_SCOPE( "shared_memory_publish" );
+
+    const std::vector< MassPoint<Dim>* >& massPoints = pSimulation.massPoints();
+    unsigned int massCount = std::min< unsigned int >( massPoints.size(), mHeader->mMaxPoints );
+    unsigned int springCount = mSprings.size();
+
+    uint8_t* slot = mMemory + SharedMemory::align( sizeof( SharedMemory::Header ) ) + ( mFrameCount % mHeader->mSlotCount ) * mHeader->mSlotSize;
+    SharedMemory::SlotHeader* slotHeader = reinterpret_cast< SharedMemory::SlotHeader* >( slot );
+    float* positions = reinterpret_cast< float* >( slot + SharedMemory::align( sizeof( SharedMemory::SlotHeader ) ) );
+    float* springMetrics = positions + mHeader->mMaxPoints * Dim;
+
+    // an odd sequence marks the slot as being written
+    uint64_t sequence = slotHeader->mSequence.load( std::memory_order_relaxed );
+    slotHeader->mSequence.store( sequence + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    slotHeader->mSimStep = pSimulation.simStep();
+    slotHeader->mPointCount = massCount;
+    slotHeader->mSpringCount = springCount;
+
+    for(unsigned int pI=0; pI<massCount; ++pI, positions += Dim)
+    {
+        const Eigen::Matrix<float, Dim, 1>& position = massPoints[pI]->position();
+        for(unsigned int d=0; d<Dim; ++d) positions[d] = position[d];
+    }
+
+    for(unsigned int sI=0; sI<springCount; ++sI, springMetrics += SharedMemory::sSpringMetricCount)
+    {
+        const Spring<Dim>* spring = mSprings[sI];
+        float extension = spring->length() - spring->restLength();
+
+        springMetrics[0] = spring->length();
+        springMetrics[1] = spring->restLength() > 0.0 ? extension / spring->restLength() : 0.0;
+        springMetrics[2] = spring->stiffness() * extension;
+    }
+
+    slotHeader->mSequence.store( sequence + 2, std::memory_order_release );
+
+    mFrameCount++;
+    mHeader->mFrameCount.store( mFrameCount, std::memory_order_release );
+}
+
+template< unsigned int Dim >
+void
+SharedMemoryPublisher<Dim>::close()
+{
+#ifdef DAB_SPRING_SHARED_MEMORY
+    if( mMemory == nullptr ) return;
+
+    // readers that still map the segment keep their mapping, new readers can no longer open it
+    munmap( mMemory, mSize );
+    shm_unlink( mName.c_str() );
+#endif
+
+    mMemory = nullptr;
+    mHeader = nullptr;
+    mSize = 0;
+}
+
+#pragma mark SharedMemoryReader Implementation
+
+template< unsigned int Dim >
+SharedMemoryReader<Dim>::SharedMemoryReader()
+: mMemory( nullptr )
+, mSize( 0 )
+, mHeader( nullptr )
+{}
+
+template< unsigned int Dim >
+SharedMemoryReader<Dim>::~SharedMemoryReader()
+{
+    close();
+}
+
+template< unsigned int Dim >
+bool
+SharedMemoryReader<Dim>::isOpen() const
+{
+    return mMemory != nullptr;
+}
+
+template< unsigned int Dim >
+unsigned int
+SharedMemoryReader<Dim>::maxPoints() const
+{
+    return mHeader != nullptr ? mHeader->mMaxPoints : 0;
+}
+
+template< unsigned int Dim >
+unsigned int
+SharedMemoryReader<Dim>::maxSprings() const
+{
+    return mHeader != nullptr ? mHeader->mMaxSprings : 0;
+}
+
+template< unsigned int Dim >
+uint64_t
+SharedMemoryReader<Dim>::latestFrame() const
+{
+    return mHeader != nullptr ? mHeader->mFrameCount.load( std::memory_order_acquire ) : 0;
+}
+
+template< unsigned int Dim >
+bool
+SharedMemoryReader<Dim>::open( const std::string& pName )
+{
+    close();
+
+#ifdef DAB_SPRING_SHARED_MEMORY
+    std::string name = SharedMemory::segmentName( pName );
+
+    int fd = shm_open( name.c_str(), O_RDONLY, 0 );
+
+    if( fd < 0 )
+    {
+        std::cout << "SharedMemoryReader: could not open " << name << "\n";
+        return false;
+    }
+
+    struct stat status;
+    size_t size = fstat( fd, &status ) == 0 ? status.st_size : 0;
+
+    if( size < SharedMemory::align( sizeof( SharedMemory::Header ) ) )
+    {
+        std::cout << "SharedMemoryReader: " << name << " is too small\n";
+        ::close( fd );
+        return false;
+    }
+
+    void* memory = mmap( nullptr, size, PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+
+    if( memory == MAP_FAILED )
+    {
+        std::cout << "SharedMemoryReader: could not map " << name << "\n";
+        return false;
+    }
+
+    const SharedMemory::Header* header = static_cast< const SharedMemory::Header* >( memory );
+    bool valid = std::memcmp( header->mMagic, "DSSM", 4 ) == 0;
+    std::atomic_thread_fence( std::memory_order_acquire );
+
+    valid = valid && header->mVersion == SharedMemory::sVersion && header->mDim == Dim && header->mSlotCount > 0;
+    valid = valid && header->mSlotSize == SharedMemory::slotSize( Dim, header->mMaxPoints, header->mMaxSprings );
+    valid = valid && size >= SharedMemory::align( sizeof( SharedMemory::Header ) ) + header->mSlotSize * header->mSlotCount;
+
+    if( valid == false )
+    {
+        std::cout << "SharedMemoryReader: " << name << " is not a shared memory segment of version " << SharedMemory::sVersion << " and dimension " << Dim << "\n";
+        munmap( memory, size );
+        return false;
+    }
+
+    mMemory = static_cast< const uint8_t* >( memory );
+    mSize = size;
+    mHeader = header;
+
+    return true;
+#else
+    std::cout << "SharedMemoryReader: shared memory is not supported on this platform\n";
+    return false;
+#endif
+}
+
+template< unsigned int Dim >
+template< class Callback >
+bool
+SharedMemoryReader<Dim>::read( Callback& pCallback, unsigned int pRetryCount ) const
+{
+    if( mMemory == nullptr ) return false;
+
+    for(unsigned int rI=0; rI<pRetryCount; ++rI)
+    {
+        uint64_t frameCount = mHeader->mFrameCount.load( std::memory_order_acquire );
+        if( frameCount == 0 ) return false;
+
+        uint64_t frame = frameCount - 1;
+        const uint8_t* slot = mMemory + SharedMemory::align( sizeof( SharedMemory::Header ) ) + ( frame % mHeader->mSlotCount ) * mHeader->mSlotSize;
+        const SharedMemory::SlotHeader* slotHeader = reinterpret_cast< const SharedMemory::SlotHeader* >( slot );
+
+        uint64_t sequence = slotHeader->mSequence.load( std::memory_order_acquire );
+        if( sequence & 1 ) continue;
+
+        SharedMemory::Frame view;
+        view.mFrame = frame;
+        view.mSimStep = slotHeader->mSimStep;
+        view.mPointCount = std::min( slotHeader->mPointCount, mHeader->mMaxPoints );
+        view.mSpringCount = std::min( slotHeader->mSpringCount, mHeader->mMaxSprings );
+        view.mPositions = reinterpret_cast< const float* >( slot + SharedMemory::align( sizeof( SharedMemory::SlotHeader ) ) );
+        view.mSpringMetrics = view.mPositions + mHeader->mMaxPoints * Dim;
+
+        pCallback( view );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( slotHeader->mSequence.load( std::memory_order_relaxed ) == sequence ) return true;
+    }
+
+    return false;
+}
+
+template< unsigned int Dim >
+void
+SharedMemoryReader<Dim>::close()
+{
+#ifdef DAB_SPRING_SHARED_MEMORY
+    if( mMemory != nullptr ) munmap( const_cast< uint8_t* >( mMemory ), mSize );
+#endif
+
+    mMemory = nullptr;
+    mHeader = nullptr;
+    mSize = 0;
+}
+
+};
+
+};
@@ -6,16 +6,209 @@
 using namespace dab;
 using namespace dab::spring;
 
+template<>
+bool
+Simulation<1>::solveChain( ChainSolver& pSolver )
+{
+    // the stiffness and damping of the chain springs as well as global damping are handled implicitly
+    // updateLength() and updateDamping() must therefore not be called before solveChain()
+    // if the springs do not form a chain, their forces are added here and the mass points are integrated explicitly
+    // with the leapfrog kernel at the chain solver's time step, in that case false is returned
+    
+    if( mChainVersion != mTopologyVersion ) detectChain();
+    
+    if( mChainMassPoints.size() == 0 )
+    {
+        updateLength();
+        updateDamping();
+        
+        PolicySolver<LeapFrogPolicy> solver( pSolver.timeStep() );
+        solve( solver );
+        
+        return false;
+    }
+    
+    DAB_SPRING_PROFILE_SCOPE( IntegrationPhase, mChainMassPoints.size() );
+    DAB_SPRING_TRACE_SCOPE( "chain" );
+    
+    pSolver.solve( mChainMassPoints, mChainSprings, mDamping );
+    mStepTime = std::max( mStepTime, pSolver.timeStep() );
+    
+    return true;
+}
+
+template<>
+void
+Simulation<2>::updateAngle()
+{
+    // restoring force towards the rest angle, perpendicular to the spring
+    // the angle difference is wrapped so that springs never rotate the long way around
+    
+    int angledSpringCount = mAngledSprings.size();
+    
+    DAB_SPRING_PROFILE_SCOPE( AnglePhase, angledSpringCount );
+    DAB_SPRING_TRACE_SCOPE( "angle" );
+    
+    AngledSpring<2>* spring;
+    Eigen::Matrix<float, 2, 1> springDirection;
+    Eigen::Matrix<float, 2, 1> force;
+    float angleStiffness;
+    float length;
+    float relAngle;
+    
+    for(int sI=0; sI<angledSpringCount; ++sI)
+    {
+        spring = mAngledSprings[sI];
+        
+        angleStiffness = spring->angleStiffness();
+        length = spring->length();
+        if( angleStiffness == 0.0 || length == 0.0 ) continue;
+        
+        springDirection = spring->direction();
+        relAngle = std::remainder( spring->relAngle1(), 2.0f * static_cast<float>( M_PI ) );
+        
+        force[0] = springDirection[1];
+        force[1] = -springDirection[0];
+        force *= angleStiffness * relAngle / length;
+        
+        spring->massPoint1()->addForce( force * -1.0 );
+        spring->massPoint2()->addForce( force );
+    }
+}
+
+template<>
+void
+Simulation<3>::updateAngle()
+{
+    // restoring forces along the azimuth (angle1) and polar (angle2) directions of the spring
+    // the azimuth difference is weighted by the sine of the polar angle, which keeps the force finite at the poles
+    
+    int angledSpringCount = mAngledSprings.size();
+    
+    DAB_SPRING_PROFILE_SCOPE( AnglePhase, angledSpringCount );
+    DAB_SPRING_TRACE_SCOPE( "angle" );
+    
+    AngledSpring<3>* spring;
+    Eigen::Matrix<float, 3, 1> azimuthDirection;
+    Eigen::Matrix<float, 3, 1> polarDirection;
+    Eigen::Matrix<float, 3, 1> force;
+    float angleStiffness;
+    float length;
+    float azimuthSin, azimuthCos, polarSin, polarCos;
+    float relAzimuth;
+    float relPolar;
+    
+    for(int sI=0; sI<angledSpringCount; ++sI)
+    {
+        spring = mAngledSprings[sI];
+        
+        angleStiffness = spring->angleStiffness();
+        length = spring->length();
+        if( angleStiffness == 0.0 || length == 0.0 ) continue;
+        
+        azimuthSin = std::sin( spring->angle1() );
+        azimuthCos = std::cos( spring->angle1() );
+        polarSin = std::sin( spring->angle2() );
+        polarCos = std::cos( spring->angle2() );
+        
+        azimuthDirection << -azimuthSin, azimuthCos, 0.0;
+        polarDirection << polarCos * azimuthCos, polarCos * azimuthSin, -polarSin;
+        
+        relAzimuth = std::remainder( spring->relAngle1(), 2.0f * static_cast<float>( M_PI ) );
+        relPolar = spring->relAngle2();
+        
+        force = azimuthDirection * ( relAzimuth * polarSin ) + polarDirection * relPolar;
+        force *= -angleStiffness / length;
+        
+        spring->massPoint1()->addForce( force * -1.0 );
+        spring->massPoint2()->addForce( force );
+    }
+}
+
+template<>
+void
+Simulation<2>::updateDir( const std::vector< DirSpring<2>* >& pSprings )
+{
+    // the bend at the hinge between the previous spring and the spring is a single angle
+    // the restoring force is the gradient of a quadratic bend energy, it acts on tip, hinge and root and conserves momentum
+    
+    int dirSpringCount = pSprings.size();
+    
+    DAB_SPRING_PROFILE_SCOPE( DirPhase, dirSpringCount );
+    DAB_SPRING_TRACE_SCOPE( "dir" );
+    
+    DirSpring<2>* spring;
+    Spring<2>* prevSpring;
+    MassPoint<2>* tipMass;
+    MassPoint<2>* hingeMass;
+    MassPoint<2>* rootMass;
+    
+    Eigen::Matrix<float, 2, 1> springDir;
+    Eigen::Matrix<float, 2, 1> prevSpringDir;
+    Eigen::Matrix<float, 2, 1> worldRestDir;
+    Eigen::Matrix<float, 2, 1> tipGradient;
+    Eigen::Matrix<float, 2, 1> rootGradient;
+    Eigen::Matrix<float, 2, 1> tipVelocity;
+    Eigen::Matrix<float, 2, 1> rootVelocity;
+    
+    float springLength;
+    float prevSpringLength;
+    float relAngle;
+    float relAngularVelocity;
+    float torque;
+    
+    for(int sI=0; sI<dirSpringCount; ++sI)
+    {
+        spring = pSprings[sI];
+        if( spring->dirStiffness() <= 0.0 ) continue;
+        
+        prevSpring = spring->firstPrevSpring();
+        if( prevSpring == NULL ) continue;
+        
+        springLength = spring->length();
+        prevSpringLength = prevSpring->length();
+        if( springLength == 0.0 || prevSpringLength == 0.0 ) continue;
+        
+        tipMass = spring->massPoint2();
+        hingeMass = spring->massPoint1();
+        rootMass = prevSpring->massPoint1();
+        
+        springDir = spring->direction();
+        prevSpringDir = prevSpring->direction();
+        worldRestDir = spring->worldRestDir();
+        
+        // signed angle from the rest direction to the current direction
+        relAngle = atan2( worldRestDir[0] * springDir[1] - worldRestDir[1] * springDir[0], worldRestDir.dot( springDir ) );
+        
+        // derivatives of the relative angle with respect to tip and root position, the hinge derivative is minus their sum
+        tipGradient << -springDir[1] / springLength, springDir[0] / springLength;
+        rootGradient << -prevSpringDir[1] / prevSpringLength, prevSpringDir[0] / prevSpringLength;
+        
+        tipVelocity = tipMass->velocity() - hingeMass->velocity();
+        rootVelocity = rootMass->velocity() - hingeMass->velocity();
+        relAngularVelocity = tipGradient.dot( tipVelocity ) + rootGradient.dot( rootVelocity );
+        
+        torque = spring->dirStiffness() * relAngle + spring->damping() * relAngularVelocity;
+        
+        tipMass->addForce( tipGradient * -torque );
+        rootMass->addForce( rootGradient * -torque );
+        hingeMass->addForce( ( tipGradient + rootGradient ) * torque );
+    }
+}
+
 template<>
 void
-Simulation<3>::updateDir()
+Simulation<3>::updateDir( const std::vector< DirSpring<3>* >& pSprings )
 {
     //std::cout << "Simulation<Dim>::updateDir3() begin\n";
     
     int massCount = mMassPoints.size();
-    int dirSpringCount = mDirSprings.size();
+    int dirSpringCount = pSprings.size();
     int springCount = mSprings.size();
     
+    DAB_SPRING_PROFILE_SCOPE( DirPhase, dirSpringCount );
+    DAB_SPRING_TRACE_SCOPE( "dir" );
+    
     Eigen::Vector3f refDir(0.0, 0.0, 1.0);
     Eigen::Vector3f rotCol1;
     Eigen::Vector3f rotCol2;
@@ -63,7 +256,7 @@ Simulation<3>::updateDir()
     
     for(int sI=0; sI<dirSpringCount; ++sI)
     {
-        spring = mDirSprings[sI];
+        spring = pSprings[sI];
         if( spring->dirStiffness() <= 0.0 ) continue;
         
         prevSpring = spring->firstPrevSpring();
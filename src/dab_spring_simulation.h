@@ -6,10 +6,27 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <unordered_set>
 #include "dab_spring_mass_point.h"
 #include "dab_spring_spring.h"
 #include "dab_spring_angled_spring.h"
 #include "dab_spring_dir_spring.h"
+#include "dab_spring_solver_policy.h"
+#include "dab_spring_solver_chain.h"
+#include "dab_spring_spatial_hash.h"
+#include "dab_spring_segment_bvh.h"
+#include "dab_spring_obstacle.h"
+#include "dab_spring_wind_field.h"
+#include "dab_spring_barnes_hut.h"
+#include "dab_spring_force_term.h"
+#include "dab_spring_pressure_body.h"
+#include "dab_spring_diagnostics.h"
+#include "dab_spring_render_buffer.h"
+#include "dab_spring_profiler.h"
+#include "dab_spring_tracer.h"
 #include "dab_singleton.h"
 
 namespace dab
@@ -40,9 +57,19 @@ public:
     void removeSpring( Spring<Dim>* pSpring );
     void removeSpring( AngledSpring<Dim>* pSpring );
     void removeSpring( DirSpring<Dim>* pSpring );
+    void removeSprings( const std::vector< Spring<Dim>* >& pSprings, const std::vector< MassPoint<Dim>* >& pMassPoints );
     
     void addMassPoint( MassPoint<Dim>* pMassPoint );
     void removeMassPoint( MassPoint<Dim>* pMassPoint );
+    void reserve( unsigned int pMassPointCount, unsigned int pSpringCount );
+    
+    const std::vector< Obstacle<Dim>* >& obstacles() const;
+    void addObstacle( Obstacle<Dim>* pObstacle );
+    void removeObstacle( Obstacle<Dim>* pObstacle );
+    
+    const std::vector< PressureBody<Dim>* >& pressureBodies() const;
+    void addPressureBody( PressureBody<Dim>* pPressureBody );
+    void removePressureBody( PressureBody<Dim>* pPressureBody );
     
     void addExternalForce( MassPoint<Dim>* pMassPoint, const Eigen::Matrix<float, Dim, 1>& pVector );
     void resetExternalForces();
@@ -51,40 +78,197 @@ public:
     float damping() const;
     float viscosityScale() const;
     float propulsionScale() const;
+    bool propulsion() const;
     void setGravity( const Eigen::Matrix<float, Dim, 1>& pGravity );
     void setDamping( float pVelocityDamping );
     void setViscosityScale( float pViscosityScale );
     void setPropulsionScale( float pPropulsionScale );
+    void setPropulsion( bool pPropulsion );
+    
+    bool wind() const;
+    const WindField<Dim>& windField() const;
+    WindField<Dim>& windField();
+    void setWind( bool pWind );
+    
+    float timeStep() const;
+    unsigned long simStep() const;
+    double simTime() const;
+    void setTimeStep( float pTimeStep );
+    
+    bool adaptiveTimeStep() const;
+    float timeStepSafety() const;
+    float maxStrainPerStep() const;
+    unsigned int maxSubSteps() const;
+    unsigned int subStepCount() const;
+    bool subStepClamped() const;
+    void setAdaptiveTimeStep( bool pAdaptiveTimeStep );
+    void setTimeStepSafety( float pTimeStepSafety );
+    void setMaxStrainPerStep( float pMaxStrainPerStep );
+    void setMaxSubSteps( unsigned int pMaxSubSteps );
+    float stableTimeStep() const;
+    
+    bool multirate() const;
+    float multirateThreshold() const;
+    unsigned int multirateSubSteps() const;
+    const std::vector< Spring<Dim>* >& stiffSprings() const;
+    const std::vector< DirSpring<Dim>* >& stiffDirSprings() const;
+    const std::vector< MassPoint<Dim>* >& stiffMassPoints() const;
+    void setMultirate( bool pMultirate );
+    void setMultirateThreshold( float pMultirateThreshold );
+    void setMultirateSubSteps( unsigned int pMultirateSubSteps );
+    void updatePartition();
+    
+    bool collision() const;
+    float collisionRadius() const;
+    float collisionStiffness() const;
+    float collisionDamping() const;
+    void setCollision( bool pCollision );
+    void setCollisionRadius( float pCollisionRadius );
+    void setCollisionStiffness( float pCollisionStiffness );
+    void setCollisionDamping( float pCollisionDamping );
+    bool springCollision() const;
+    float springCollisionRadius() const;
+    void setSpringCollision( bool pSpringCollision );
+    void setSpringCollisionRadius( float pSpringCollisionRadius );
+    
+    bool longRange() const;
+    float longRangeTheta() const;
+    const PowerLawKernel<Dim>& longRangeKernel() const;
+    void setLongRange( bool pLongRange );
+    void setLongRangeTheta( float pLongRangeTheta );
+    void setLongRangeKernel( const PowerLawKernel<Dim>& pLongRangeKernel );
+    
+    const std::vector< MassPoint<Dim>* >& chainMassPoints() const;
+    const std::vector< Spring<Dim>* >& chainSprings() const;
+    bool setChain( const std::vector< MassPoint<Dim>* >& pMassPoints );
+    bool detectChain();
+    
+    bool diagnostics() const;
+    const Diagnostics<Dim>& lastDiagnostics() const;
+    void setDiagnostics( bool pDiagnostics );
+    
+    bool renderExport() const;
+    const RenderBuffer<Dim>& renderBuffer() const;
+    void setRenderExport( bool pRenderExport );
     
     void updateLength();
+    void updateLength( const std::vector< Spring<Dim>* >& pSprings );
     void updateAngle();
 	void updateDir();
+	void updateDir( const std::vector< DirSpring<Dim>* >& pSprings );
     void updateGravity();
     void updateDamping();
-    //void updatePropulsion();
-    
+    void updateCollision();
+    void updateSpringCollision();
+    void updateLongRange();
+    void updatePressure();
+    template<class Kernel> void updateLongRange( const Kernel& pKernel );
+    void updatePropulsion();
+    void updateWind();
+    template<class... Terms> void updateForceTerms( const Terms&... pTerms );
+    template<class... Terms> void updateForceTerms( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings, const Terms&... pTerms );
+    template<class... Terms> void updateForces( const Terms&... pTerms );
+    
+    template<class Policy> void solve();
     template<class Solver> void solve( Solver& pSolver );
+    template<class Solver> void solve( Solver& pSolver, const std::vector< MassPoint<Dim>* >& pMassPoints );
+    template<class Solver, class... Terms> void solveMultirate( Solver& pSolver, const Terms&... pTerms );
+    bool solveChain( ChainSolver& pSolver );
+    void resolveObstacles();
+    template<class Policy, class... Terms> unsigned int step( float pFrameTime, const Terms&... pTerms );
+    template<class Solver, class... Terms> unsigned int step( Solver& pSolver, float pFrameTime, const Terms&... pTerms );
     void update();
     void clear();
     
+#ifdef DAB_SPRING_PROFILE
+    const Profiler& profiler() const;
+    Profiler& profiler();
+#endif
+    
 protected:
     std::vector< MassPoint<Dim>* > mMassPoints;
+    std::unordered_set< MassPoint<Dim>* > mMassPointSet;
     std::vector< Spring<Dim>* > mSprings;
     std::vector< AngledSpring<Dim>* > mAngledSprings;
     std::vector< DirSpring<Dim>* > mDirSprings;
+    std::vector< Obstacle<Dim>* > mObstacles;
+    std::vector< PressureBody<Dim>* > mPressureBodies;
     unsigned long mSimStep;
+    double mSimTime;
+    float mStepTime;
+    unsigned long mTopologyVersion;
     
     Eigen::Matrix<float, Dim, 1> mGravity;
-    Eigen::Matrix<float, Dim, 1> windForce;
-    Eigen::Matrix<float, Dim, 1> windForceLimit;
     float mViscosityScale;
     float mPropulsionScale;
+    bool mPropulsion;
+    unsigned long mPropulsionVersion;
+    std::vector< Spring<Dim>* > mPropulsionSprings;
+    
+    bool mWind;
+    unsigned long mWindStep;
+    WindField<Dim> mWindField;
     
     float mDamping;
+    
+    float mTimeStep;
+    bool mAdaptiveTimeStep;
+    float mTimeStepSafety;
+    float mMaxStrainPerStep;
+    unsigned int mMaxSubSteps;
+    unsigned int mSubStepCount;
+    bool mSubStepClamped;
+    bool mStepping;
+    
+    bool mMultirate;
+    float mMultirateThreshold;
+    unsigned int mMultirateSubSteps;
+    unsigned long mPartitionVersion;
+    std::vector< Spring<Dim>* > mStiffSprings;
+    std::vector< Spring<Dim>* > mSoftSprings;
+    std::unordered_set< Spring<Dim>* > mStiffSpringSet;
+    std::vector< DirSpring<Dim>* > mStiffDirSprings;
+    std::vector< DirSpring<Dim>* > mSoftDirSprings;
+    std::vector< MassPoint<Dim>* > mStiffMassPoints;
+    std::vector< MassPoint<Dim>* > mSoftMassPoints;
+    std::vector< Eigen::Matrix<float, Dim, 1> > mStiffSlowForces;
+    
+    bool mCollision;
+    float mCollisionRadius;
+    float mCollisionStiffness;
+    float mCollisionDamping;
+    SpatialHash<Dim> mCollisionHash;
+    std::vector< Eigen::Matrix<float, Dim, 1> > mCollisionPositions;
+    bool mSpringCollision;
+    float mSpringCollisionRadius;
+    unsigned long mSpringBVHVersion;
+    SegmentBVH<Dim> mSpringBVH;
+    
+    bool mLongRange;
+    PowerLawKernel<Dim> mLongRangeKernel;
+    BarnesHutTree<Dim> mLongRangeTree;
+    std::vector< Eigen::Matrix<float, Dim, 1> > mLongRangePositions;
+    
+    unsigned long mChainVersion;
+    std::vector< MassPoint<Dim>* > mChainMassPoints;
+    std::vector< Spring<Dim>* > mChainSprings;
+    
+    bool mDiagnostics;
+    Diagnostics<Dim> mStepDiagnostics;
+    Diagnostics<Dim> mLastDiagnostics;
+    
+    bool mRenderExport;
+    unsigned long mRenderBufferVersion;
+    RenderBuffer<Dim> mRenderBuffer;
    
     std::map< MassPoint<Dim>*, Eigen::Matrix<float, Dim, 1> > mExternalForces;
     
+#ifdef DAB_SPRING_PROFILE
+    Profiler mProfiler;
+#endif
+    
     bool checkMassPointInSpring( MassPoint<Dim>* pMassPoint ) const;
+    float stableTimeStep( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings, const std::vector< DirSpring<Dim>* >& pDirSprings, const std::unordered_set< Spring<Dim>* >* pSkipSprings ) const;
 };
 
 typedef Simulation<1>  Simulation1D;
@@ -96,12 +280,41 @@ typedef Simulation<3>  Simulation3D;
 template< unsigned int Dim >
 Simulation<Dim>::Simulation()
 : mSimStep(0)
+, mSimTime(0.0)
+, mStepTime(0.0)
+, mTopologyVersion(0)
 , mGravity( Eigen::Matrix<float, Dim, 1>::Constant(0.0) )
 , mDamping( 0.1 )
-, windForce( Eigen::Matrix<float, Dim, 1>::Constant(0.0))
-, windForceLimit( Eigen::Matrix<float, Dim, 1>::Constant(0.00005) )
 , mViscosityScale( 0.02 )
 , mPropulsionScale( 0.02 )
+, mPropulsion( false )
+, mPropulsionVersion( std::numeric_limits<unsigned long>::max() )
+, mWind( false )
+, mWindStep( std::numeric_limits<unsigned long>::max() )
+, mTimeStep( 0.1 )
+, mAdaptiveTimeStep( false )
+, mTimeStepSafety( 0.8 )
+, mMaxStrainPerStep( 0.1 )
+, mMaxSubSteps( 64 )
+, mSubStepCount( 1 )
+, mSubStepClamped( false )
+, mStepping( false )
+, mMultirate( false )
+, mMultirateThreshold( 10.0 )
+, mMultirateSubSteps( 8 )
+, mPartitionVersion( std::numeric_limits<unsigned long>::max() )
+, mCollision( false )
+, mCollisionRadius( 1.0 )
+, mCollisionStiffness( 1.0 )
+, mCollisionDamping( 0.1 )
+, mSpringCollision( false )
+, mSpringCollisionRadius( 0.5 )
+, mSpringBVHVersion( std::numeric_limits<unsigned long>::max() )
+, mLongRange( false )
+, mChainVersion( std::numeric_limits<unsigned long>::max() )
+, mDiagnostics( false )
+, mRenderExport( false )
+, mRenderBufferVersion( std::numeric_limits<unsigned long>::max() )
 {}
 
 template< unsigned int Dim >
@@ -156,6 +369,8 @@ template< unsigned int Dim >
 void
 Simulation<Dim>::addSpring( Spring<Dim>* pSpring )
 {
+    mTopologyVersion++;
+    
     mSprings.push_back( pSpring );
     
     MassPoint<Dim>* mp1 = pSpring->massPoint1();
@@ -169,6 +384,8 @@ template< unsigned int Dim >
 void
 Simulation<Dim>::addSpring( AngledSpring<Dim>* pSpring )
 {
+    mTopologyVersion++;
+    
     mSprings.push_back( pSpring );
     mAngledSprings.push_back( pSpring );
     
@@ -183,6 +400,8 @@ template< unsigned int Dim >
 void
 Simulation<Dim>::addSpring( DirSpring<Dim>* pSpring )
 {
+    mTopologyVersion++;
+    
     mSprings.push_back( pSpring );
     mDirSprings.push_back( pSpring );
     
@@ -197,6 +416,8 @@ template< unsigned int Dim >
 void
 Simulation<Dim>::removeSpring( Spring<Dim>* pSpring )
 {
+    mTopologyVersion++;
+    
     auto springIter = std::find(mSprings.begin(), mSprings.end(), pSpring);
     if(springIter != mSprings.end()) mSprings.erase(springIter);
     
@@ -208,6 +429,8 @@ template< unsigned int Dim >
 void
 Simulation<Dim>::removeSpring( AngledSpring<Dim>* pSpring )
 {
+    mTopologyVersion++;
+    
     auto springIter = std::find(mSprings.begin(), mSprings.end(), pSpring);
     if(springIter != mSprings.end()) mSprings.erase(springIter);
     
@@ -222,6 +445,8 @@ template< unsigned int Dim >
 void
 Simulation<Dim>::removeSpring( DirSpring<Dim>* pSpring )
 {
+    mTopologyVersion++;
+    
     auto springIter = std::find(mSprings.begin(), mSprings.end(), pSpring);
     if(springIter != mSprings.end()) mSprings.erase(springIter);
     
@@ -232,23 +457,128 @@ Simulation<Dim>::removeSpring( DirSpring<Dim>* pSpring )
     if( checkMassPointInSpring( pSpring->massPoint2() ) == false  ) removeMassPoint( pSpring->massPoint2() );
 }
     
+template< unsigned int Dim >
+void
+Simulation<Dim>::removeSprings( const std::vector< Spring<Dim>* >& pSprings, const std::vector< MassPoint<Dim>* >& pMassPoints )
+{
+    // removes springs of any type and mass points in a single pass over each list
+    // as with removeSpring, mass points of the removed springs that no remaining spring uses are removed too
+    
+    std::unordered_set< Spring<Dim>* > springSet( pSprings.begin(), pSprings.end() );
+    std::unordered_set< MassPoint<Dim>* > massPointSet( pMassPoints.begin(), pMassPoints.end() );
+    
+    auto removedSpring = [&springSet]( Spring<Dim>* pSpring ) { return springSet.count( pSpring ) > 0; };
+    
+    mSprings.erase( std::remove_if( mSprings.begin(), mSprings.end(), removedSpring ), mSprings.end() );
+    mAngledSprings.erase( std::remove_if( mAngledSprings.begin(), mAngledSprings.end(), removedSpring ), mAngledSprings.end() );
+    mDirSprings.erase( std::remove_if( mDirSprings.begin(), mDirSprings.end(), removedSpring ), mDirSprings.end() );
+    
+    std::unordered_set< MassPoint<Dim>* > usedMassPoints;
+    for(auto spring : mSprings)
+    {
+        usedMassPoints.insert( spring->massPoint1() );
+        usedMassPoints.insert( spring->massPoint2() );
+    }
+    for(auto spring : pSprings)
+    {
+        if( usedMassPoints.count( spring->massPoint1() ) == 0 ) massPointSet.insert( spring->massPoint1() );
+        if( usedMassPoints.count( spring->massPoint2() ) == 0 ) massPointSet.insert( spring->massPoint2() );
+    }
+    
+    mMassPoints.erase( std::remove_if( mMassPoints.begin(), mMassPoints.end(), [&massPointSet]( MassPoint<Dim>* pMassPoint ) { return massPointSet.count( pMassPoint ) > 0; } ), mMassPoints.end() );
+    
+    for(auto massPoint : massPointSet)
+    {
+        mMassPointSet.erase( massPoint );
+        mExternalForces.erase( massPoint );
+    }
+    
+    mTopologyVersion++;
+}
+    
 template< unsigned int Dim >
 void
 Simulation<Dim>::addMassPoint( MassPoint<Dim>* pMassPoint )
 {
-    auto massIter = std::find(mMassPoints.begin(), mMassPoints.end(), pMassPoint );
-    if( massIter == mMassPoints.end() ) mMassPoints.push_back( pMassPoint );
+    // the set keeps adding springs in bulk linear, mass points are shared by many springs
+    if( mMassPointSet.insert( pMassPoint ).second )
+    {
+        mMassPoints.push_back( pMassPoint );
+        mTopologyVersion++;
+    }
 }
     
 template< unsigned int Dim >
 void
 Simulation<Dim>::removeMassPoint( MassPoint<Dim>* pMassPoint )
 {
-    auto forceIter = std::find(mExternalForces.begin(), mExternalForces.end(), pMassPoint );
-    if( forceIter != mExternalForces.end() ) mExternalForces.erase( forceIter );
+    mExternalForces.erase( pMassPoint );
+    
+    if( mMassPointSet.erase( pMassPoint ) == 0 ) return;
     
     auto massIter = std::find(mMassPoints.begin(), mMassPoints.end(), pMassPoint );
-    if( massIter != mMassPoints.end() ) mMassPoints.erase( massIter );
+    if( massIter != mMassPoints.end() )
+    {
+        mMassPoints.erase( massIter );
+        mTopologyVersion++;
+    }
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::reserve( unsigned int pMassPointCount, unsigned int pSpringCount )
+{
+    // to be called before adding large numbers of springs and mass points
+    
+    mMassPoints.reserve( pMassPointCount );
+    mMassPointSet.reserve( pMassPointCount );
+    mSprings.reserve( pSpringCount );
+}
+    
+template< unsigned int Dim >
+const std::vector< Obstacle<Dim>* >&
+Simulation<Dim>::obstacles() const
+{
+    return mObstacles;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::addObstacle( Obstacle<Dim>* pObstacle )
+{
+    auto obstacleIter = std::find(mObstacles.begin(), mObstacles.end(), pObstacle );
+    if( obstacleIter == mObstacles.end() ) mObstacles.push_back( pObstacle );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::removeObstacle( Obstacle<Dim>* pObstacle )
+{
+    auto obstacleIter = std::find(mObstacles.begin(), mObstacles.end(), pObstacle );
+    if( obstacleIter != mObstacles.end() ) mObstacles.erase( obstacleIter );
+}
+    
+template< unsigned int Dim >
+const std::vector< PressureBody<Dim>* >&
+Simulation<Dim>::pressureBodies() const
+{
+    return mPressureBodies;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::addPressureBody( PressureBody<Dim>* pPressureBody )
+{
+    auto bodyIter = std::find(mPressureBodies.begin(), mPressureBodies.end(), pPressureBody );
+    if( bodyIter == mPressureBodies.end() ) mPressureBodies.push_back( pPressureBody );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::removePressureBody( PressureBody<Dim>* pPressureBody )
+{
+    auto bodyIter = std::find(mPressureBodies.begin(), mPressureBodies.end(), pPressureBody );
+    if( bodyIter != mPressureBodies.end() ) mPressureBodies.erase( bodyIter );
 }
     
 template< unsigned int Dim >
@@ -262,9 +592,9 @@ template< unsigned int Dim >
 void
 Simulation<Dim>::addExternalForce( MassPoint<Dim>* pMassPoint, const Eigen::Matrix<float, Dim, 1>& pForce )
 {
-    auto forceIter = std::find(mExternalForces.begin(), mExternalForces.end(), pMassPoint );
+    auto forceIter = mExternalForces.find( pMassPoint );
     
-    if(forceIter != mExternalForces.end()) *forceIter += pForce;
+    if(forceIter != mExternalForces.end()) forceIter->second += pForce;
     else mExternalForces[ pMassPoint ] = pForce;
 }
     
@@ -296,6 +626,13 @@ Simulation<Dim>::propulsionScale() const
     return mPropulsionScale;
 }
     
+template< unsigned int Dim >
+bool
+Simulation<Dim>::propulsion() const
+{
+    return mPropulsion;
+}
+    
 template< unsigned int Dim >
 void
 Simulation<Dim>::setGravity( const Eigen::Matrix<float, Dim, 1>& pGravity )
@@ -326,305 +663,1496 @@ Simulation<Dim>::setPropulsionScale( float pPropulsionScale )
     
 template< unsigned int Dim >
 void
-Simulation<Dim>::updateLength()
+Simulation<Dim>::setPropulsion( bool pPropulsion )
 {
-    int massCount = mMassPoints.size();
-    int springCount = mSprings.size();
+    mPropulsion = pPropulsion;
+}
     
-    // accumulate forces
-    Eigen::Matrix<float, Dim,1> springDirection;
-    Eigen::Matrix<float, Dim,1> force;
+template< unsigned int Dim >
+bool
+Simulation<Dim>::wind() const
+{
+    return mWind;
+}
     
-    Spring<Dim>* spring;
-    float springStiffness;
-    MassPoint<Dim>* mass1;
-    MassPoint<Dim>* mass2;
-
-    for(int sI=0; sI<springCount; ++sI)
-    {
-        spring = mSprings[sI];
-        
-        springStiffness = spring->stiffness();
-        if(springStiffness == 0.0) continue;
-        springDirection = spring->direction();
-        
-        mass1 = spring->massPoint1();
-        mass2 = spring->massPoint2();
-        
-        force = springDirection * springStiffness * ( spring->length() - spring->restLength() );
-        force += ( mass2->velocity() - mass1->velocity() ) * spring->damping();
-        
-        mass1->addForce( force );
-        mass2->addForce( force * -1.0 );
-    }
+template< unsigned int Dim >
+const WindField<Dim>&
+Simulation<Dim>::windField() const
+{
+    return mWindField;
+}
     
-    //	std::cout << "Simulation<Dim>::update() end\n";
+template< unsigned int Dim >
+WindField<Dim>&
+Simulation<Dim>::windField()
+{
+    return mWindField;
 }
     
 template< unsigned int Dim >
 void
-Simulation<Dim>::updateAngle()
+Simulation<Dim>::setWind( bool pWind )
 {
-    //int massCount = mMassPoints.size();
-    //int angleSpringCount = mAngledSprings.size();
-    //
-    //AngledSpring<Dim>* spring;
-    //MassPoint<Dim>* mass1;
-    //MassPoint<Dim>* mass2;
-
-    //// TODO
+    mWind = pWind;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::timeStep() const
+{
+    return mTimeStep;
+}
+    
+template< unsigned int Dim >
+unsigned long
+Simulation<Dim>::simStep() const
+{
+    return mSimStep;
+}
+    
+template< unsigned int Dim >
+double
+Simulation<Dim>::simTime() const
+{
+    // sum of the time steps actually integrated, advanced by update()
+    return mSimTime;
 }
     
 template< unsigned int Dim >
 void
-Simulation<Dim>::updateDir()
+Simulation<Dim>::setTimeStep( float pTimeStep )
 {
-    //TODO: for other dimensions than 3
+    mTimeStep = pTimeStep;
 }
-
-template<>
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::adaptiveTimeStep() const
+{
+    return mAdaptiveTimeStep;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::timeStepSafety() const
+{
+    return mTimeStepSafety;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::maxStrainPerStep() const
+{
+    return mMaxStrainPerStep;
+}
+    
+template< unsigned int Dim >
+unsigned int
+Simulation<Dim>::maxSubSteps() const
+{
+    return mMaxSubSteps;
+}
+    
+template< unsigned int Dim >
+unsigned int
+Simulation<Dim>::subStepCount() const
+{
+    return mSubStepCount;
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::subStepClamped() const
+{
+    // true if the last step() needed more than mMaxSubSteps sub steps, its sub steps then exceeded the stable time step
+    return mSubStepClamped;
+}
+    
+template< unsigned int Dim >
 void
-Simulation<3>::updateDir();
-
+Simulation<Dim>::setAdaptiveTimeStep( bool pAdaptiveTimeStep )
+{
+    mAdaptiveTimeStep = pAdaptiveTimeStep;
+}
     
 template< unsigned int Dim >
 void
-Simulation<Dim>::updateGravity()
+Simulation<Dim>::setTimeStepSafety( float pTimeStepSafety )
 {
-    int massCount = mMassPoints.size();
-    int springCount = mSprings.size();
-    MassPoint<Dim>* mass;
+    mTimeStepSafety = pTimeStepSafety;
+}
     
-    for(int pI=0; pI<massCount; ++pI)
-    {
-        mass = mMassPoints[pI];
-        
-        //        // debug
-        //        if( mMassPoints.indexOf( mass ) == 0 ) std::cout << "Simulation<Dim>::updateGravity() mass " << mass << " add force  " << mGravity << "\n";
-        //        // debug done
-        
-        mass->addForce( mGravity );
-    }
+template< unsigned int Dim >
+void
+Simulation<Dim>::setMaxStrainPerStep( float pMaxStrainPerStep )
+{
+    mMaxStrainPerStep = pMaxStrainPerStep;
 }
     
 template< unsigned int Dim >
 void
-Simulation<Dim>::updateDamping()
+Simulation<Dim>::setMaxSubSteps( unsigned int pMaxSubSteps )
 {
-    int massCount = mMassPoints.size();
-    int springCount = mSprings.size();
-    MassPoint<Dim>* mass;
-    Eigen::Matrix<float, Dim, 1> force;
+    mMaxSubSteps = std::max( pMaxSubSteps, 1u );
+}
     
-    float damping_1 = mDamping * -1.0;
+template< unsigned int Dim >
+float
+Simulation<Dim>::stableTimeStep() const
+{
+    // with multirate the stiff springs are sub-stepped separately, the step itself is only bounded by the soft springs
+    if( mMultirate && mPartitionVersion == mTopologyVersion ) return stableTimeStep( mMassPoints, mSoftSprings, mSoftDirSprings, &mStiffSpringSet );
     
-    for(int pI=0; pI<massCount; ++pI)
-    {
-        mass = mMassPoints[pI];
-        force = mass->velocity() * damping_1;
-        
-        //        // debug
-        //        if( mMassPoints.indexOf( mass ) == 0 ) std::cout << "Simulation<Dim>::updateDamping() mass " << mass << " add force  " << force << "\n";
-        //        // debug done
-        
-        mass->addForce( force );
-    }
+    return stableTimeStep( mMassPoints, mSprings, mDirSprings, NULL );
 }
     
-//    template< unsigned int Dim >
-//    void
-//    Simulation<Dim>::updatePropulsion()
-//    {
-//        int springCount = mSprings.size();
-//        
-//        QVector< MassPoint< Dim>* > propelledMassPoints;
-//        
-//        for(int sI=0; sI<springCount; ++sI)
-//        {
-//            MassPoint3D* mass1 = mSprings[sI]->massPoint1();
-//            MassPoint3D* mass2 = mSprings[sI]->massPoint2();
-//            const vis2::Vector3f& dir = mSprings[sI]->direction();
-//            
-//            if( propelledMassPoints.contains(mass1) ) continue;
-//            else propelledMassPoints.append(mass1);
-//            
-//            float springLength = dir.length();
-//            
-//            if( springLength < 0.0001 ) continue;
-//            
-//            vis2::Vector3f force;
-//            vis2::Vector3f velDiff;
-//            vis2::Vector3f velSum;
-//            vis2::Vector3f normVel;
-//            vis2::Vector3f normVelDiff;
-//            vis2::Vector3f normVelSum;
-//            vis2::Vector3f normDir;
-//            vis2::Vector3f tmp;
-//            vis2::Vector3f normN;
-//            float dampAmount;
-//            float propAmount;
-//            float velLength;
-//            float velDiffLength;
-//            float velSumLength;
-//            vis2::Vector3f propForce;
-//            vis2::Vector3f dampForce;
-//            
-//            // mass point 1 propulsion
-//            {
-//                const vis2::Vector3f& vel = mass1->velocity();
-//                velLength = vel.length();
-//                velDiff = mass1->velocity() - mass2->velocity();
-//                velDiffLength = velDiff.length();
-//                if( velDiffLength < 0.0001 ) continue;
-//                
-//                velSum = mass1->velocity() + mass2->velocity();
-//                velSumLength = velSum.length();
-//                if( velSumLength < 0.0001 ) continue;
-//                
-//                //std::cout << "spring dir " << dir << " mass1 vel " << mass1->velocity() << " mass2 vel " << mass2->velocity() << " diff " << velDiff << "\n";
-//                
-//                normVel = vel.normalised();
-//                normVelDiff = velDiff.normalised();
-//                normVelSum = velSum.normalised();
-//                normDir = dir.normalised();
-//                
-//                // calculate propulsion
-//                tmp = normDir.cross(normVelDiff);
-//                tmp.normalise();
-//                normN = tmp.cross(normDir);
-//                normN.normalise();
-//                
-//                propAmount = fabs( normVelDiff.dot( normN ) ) * velDiffLength * springLength;
-//                propForce = normDir * propAmount * mPropulsionScale * -1.0;
-//                
-//                //std::cout << "prop tmp " << tmp << " N " << normN << " amnt " << propAmount << " force " <<  propForce << "\n";
-//                
-//                // calculate damping
-//                tmp = normDir.cross(normVel);
-//                tmp.normalise();
-//                normN = tmp.cross(normDir);
-//                normN.normalise();
-//                
-//                //            dampAmount = fabs( normVel.dot( normN ) ) * velLength * springLength;
-//                //            dampForce = normDir * dampAmount * mViscosityScale;
-//                
-//                dampAmount = fabs( normVelSum.dot( normN ) ) * velLength * springLength;
-//                dampForce = normN * dampAmount * mViscosityScale;
-//                
-//                dampAmount = fabs( normVel.dot( normN ) ) * velLength * springLength;
-//                dampForce += normDir * dampAmount * mViscosityScale;
-//                
-//                
-//                //std::cout << "damp tmp " << tmp << " N " << normN << " amnt " << dampAmount << " force " <<  dampForce << "\n";
-//                
-//                force = propForce - dampForce;
-//                
-//                //            // debug
-//                //            if( mMassPoints.indexOf( mass1 ) == 0 ) std::cout << "Simulation<Dim>::updatePropulsion() mass1 " << mass1 << " dampForce  " << dampForce << " propForce " << propForce << "\n";
-//                //            // debug done
-//                
-//                mass1->addForce( propForce - dampForce );
-//            }
-//        }
-//    }
-    
 template< unsigned int Dim >
-template<class Solver>
-void
-Simulation<Dim>::solve( Solver& pSolver )
+float
+Simulation<Dim>::stableTimeStep( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings, const std::vector< DirSpring<Dim>* >& pDirSprings, const std::unordered_set< Spring<Dim>* >* pSkipSprings ) const
 {
-    //std::cout << "Simulation<Dim>::solve( Solver& pSolver ) begin\n";
+    // the leapfrog update of x'' = -w^2 x - g x' is stable for h^2 w^2 + 2 h g < 4
+    // the bound only holds for the symplectic leapfrog kernel, explicit euler is not stable for any time step of an undamped spring
+    // w^2 and g are bounded per mass point by summing the stiffness and damping of all attached springs (gershgorin), except those in pSkipSprings
+    // in addition, none of pSprings may change its length by more than mMaxStrainPerStep of its rest length within one step
+    
+    int massCount = pMassPoints.size();
+    int springCount = pSprings.size();
+    int dirSpringCount = pDirSprings.size();
+    
+    float timeStep = std::numeric_limits<float>::max();
     
-    int massCount = mMassPoints.size();
     MassPoint<Dim>* mass;
+    Spring<Dim>* spring;
+    DirSpring<Dim>* dirSpring;
+    float invMass;
+    float omega2;
+    float gamma;
     
-    // numerical integration
     for(int pI=0; pI<massCount; ++pI)
     {
-        mass = mMassPoints[pI];
-        
-        Eigen::Matrix<float, Dim,1>& mpForce = mass->force();
-        
-        for(int d=0; d<Dim; ++d)
-        {
-            if( isnan( mpForce[d] ) ) mpForce[d] = 0.0;
-        }
+        mass = pMassPoints[pI];
+        if( mass->mass() <= 0.0 ) continue;
         
-        //if(pI == 0) std::cout << "point " << pI << " mass " << mass << " pos " << mass->position() << " force  " << mass->force() << "\n";
-
-        float mpMass = mass->mass();
-        Eigen::Matrix<float, Dim, 1>& mpPosition = mass->position();
-        Eigen::Matrix<float, Dim, 1>& mpVelocity = mass->velocity();
-        Eigen::Matrix<float, Dim, 1>& mpBackupPosition = mass->backupPosition();
-        Eigen::Matrix<float, Dim, 1>& mpBackupVelocity = mass->backupVelocity();
+        invMass = 1.0 / mass->mass();
         
-        Eigen::Matrix<float, Dim, 1> scaledForce = mpForce / mpMass;
+        const std::vector< Spring<Dim>* >& springs = mass->springs();
+        int massSpringCount = springs.size();
         
-        if( mpMass > 0.0 ) pSolver.solve<Dim>( mpPosition, mpVelocity, scaledForce, mpBackupPosition, mpBackupVelocity );
-
+        omega2 = 0.0;
+        gamma = mDamping * invMass;
         
-        // is nan check
-        for(int d=0; d<Dim; ++d)
+        for(int sI=0; sI<massSpringCount; ++sI)
         {
-            if( isnan( mpBackupPosition[d] ) )
-            {
-                mpBackupPosition[d] = mpPosition[d];
-            }
-            if( isnan( mpBackupVelocity[d] ) )
-            {
-                mpBackupVelocity[d] = mpVelocity[d];
-            }
+            if( pSkipSprings != NULL && pSkipSprings->find( springs[sI] ) != pSkipSprings->end() ) continue;
+            
+            omega2 += 2.0 * springs[sI]->stiffness() * invMass;
+            gamma += 2.0 * springs[sI]->damping() * invMass;
         }
+        
+        if( omega2 > 0.0 ) timeStep = std::min( timeStep, ( std::sqrt( gamma * gamma + 4.0f * omega2 ) - gamma ) / omega2 );
+        else if( gamma > 0.0 ) timeStep = std::min( timeStep, 2.0f / gamma );
     }
     
-    //std::cout << "Simulation<Dim>::solve( Solver& pSolver ) end\n";
-}
-    
-template< unsigned int Dim >
-void
-Simulation<Dim>::update()
-{
-    //    std::cout << "SpringSim gravity " << mGravity << " damping " << mDamping << " propScale " << mPropulsionScale << " visScale " << mViscosityScale << "\n";
-    
-    int massCount = mMassPoints.size();
-    int springCount = mSprings.size();
-    
-    //std::cout << "massCount " << massCount << " springCount " << springCount << "\n";
-    
-    // refresh backups
-    for(int pI=0; pI<massCount; ++pI)
+    for(int sI=0; sI<dirSpringCount; ++sI)
     {
-        mMassPoints[pI]->update();
+        dirSpring = pDirSprings[sI];
+        if( dirSpring->dirStiffness() <= 0.0 ) continue;
         
-        //        // debug
-        //        std::cout << "mp " << pI << " : " << mMassPoints[pI];
-        //        const QVector< Spring<Dim>* >& springs = mMassPoints[pI]->springs();
-        //        for(int sI=0; sI<springs.size(); ++sI) std::cout << " sI " << sI << " : " << springs[sI];
-        //        std::cout << "\n";
-        //        // debug done
+        invMass = 0.0;
+        if( dirSpring->massPoint1()->mass() > 0.0 ) invMass += 1.0 / dirSpring->massPoint1()->mass();
+        if( dirSpring->massPoint2()->mass() > 0.0 ) invMass += 1.0 / dirSpring->massPoint2()->mass();
         
+        omega2 = 2.0 * dirSpring->dirStiffness() * invMass;
+        if( omega2 > 0.0 ) timeStep = std::min( timeStep, 2.0f / std::sqrt( omega2 ) );
     }
-    for(int sI=0; sI<springCount; ++sI)
+    
+    if( mMaxStrainPerStep > 0.0 )
     {
-        mSprings[sI]->update();
+        float velocityDiff;
         
-        //        // debug
-        //        std::cout << "sI " << sI << " : " << mSprings[sI] << " mp1 " << mSprings[sI]->massPoint1() << " mp2 " << mSprings[sI]->massPoint2() << "\n";
-        //        // debug done
+        for(int sI=0; sI<springCount; ++sI)
+        {
+            spring = pSprings[sI];
+            if( spring->restLength() <= 0.0 ) continue;
+            
+            velocityDiff = std::abs( ( spring->massPoint2()->velocity() - spring->massPoint1()->velocity() ).dot( spring->direction() ) );
+            if( velocityDiff > 0.0 ) timeStep = std::min( timeStep, mMaxStrainPerStep * spring->restLength() / velocityDiff );
+        }
     }
     
-    mSimStep++;
+    return timeStep * mTimeStepSafety;
 }
     
 template< unsigned int Dim >
-void
-Simulation<Dim>::clear()
+bool
+Simulation<Dim>::multirate() const
 {
-    mExternalForces.clear();
-	mSprings.clear();
-	mAngledSprings.clear();
+    return mMultirate;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::multirateThreshold() const
+{
+    return mMultirateThreshold;
+}
+    
+template< unsigned int Dim >
+unsigned int
+Simulation<Dim>::multirateSubSteps() const
+{
+    return mMultirateSubSteps;
+}
+    
+template< unsigned int Dim >
+const std::vector< Spring<Dim>* >&
+Simulation<Dim>::stiffSprings() const
+{
+    return mStiffSprings;
+}
+    
+template< unsigned int Dim >
+const std::vector< DirSpring<Dim>* >&
+Simulation<Dim>::stiffDirSprings() const
+{
+    return mStiffDirSprings;
+}
+    
+template< unsigned int Dim >
+const std::vector< MassPoint<Dim>* >&
+Simulation<Dim>::stiffMassPoints() const
+{
+    return mStiffMassPoints;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setMultirate( bool pMultirate )
+{
+    // the partition into stiff and soft springs is only rebuilt automatically when springs or mass points are added or removed
+    // after changing the stiffness or dir stiffness of a spring or the mass of a mass point updatePartition() has to be called,
+    // otherwise a spring that became stiff is integrated with the full time step and the simulation can blow up
+    
+    mMultirate = pMultirate;
+    
+    if( mMultirate ) updatePartition();
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setMultirateThreshold( float pMultirateThreshold )
+{
+    mMultirateThreshold = pMultirateThreshold;
+    
+    updatePartition();
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setMultirateSubSteps( unsigned int pMultirateSubSteps )
+{
+    // with an adaptive time step the stiff sub steps are derived from the stable time step of the stiff springs instead
+    mMultirateSubSteps = std::max( pMultirateSubSteps, 1u );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updatePartition()
+{
+    // a spring is stiff if its stiffness to reduced mass ratio exceeds mMultirateThreshold
+    // mass points attached to stiff springs are sub-stepped, all others are integrated with the full time step
+    // to be called after changing spring stiffnesses or masses, see setMultirate()
+    
+    int massCount = mMassPoints.size();
+    int springCount = mSprings.size();
+    int dirSpringCount = mDirSprings.size();
+    
+    mStiffSprings.clear();
+    mSoftSprings.clear();
+    mStiffSpringSet.clear();
+    mStiffDirSprings.clear();
+    mSoftDirSprings.clear();
+    mStiffMassPoints.clear();
+    mSoftMassPoints.clear();
+    
+    std::unordered_set< MassPoint<Dim>* > stiffMassPoints;
+    
+    Spring<Dim>* spring;
+    DirSpring<Dim>* dirSpring;
+    MassPoint<Dim>* mass1;
+    MassPoint<Dim>* mass2;
+    float invMass;
+    
+    for(int sI=0; sI<springCount; ++sI)
+    {
+        spring = mSprings[sI];
+        mass1 = spring->massPoint1();
+        mass2 = spring->massPoint2();
+        
+        invMass = 0.0;
+        if( mass1->mass() > 0.0 ) invMass += 1.0 / mass1->mass();
+        if( mass2->mass() > 0.0 ) invMass += 1.0 / mass2->mass();
+        
+        if( spring->stiffness() * invMass > mMultirateThreshold )
+        {
+            mStiffSprings.push_back( spring );
+            mStiffSpringSet.insert( spring );
+            stiffMassPoints.insert( mass1 );
+            stiffMassPoints.insert( mass2 );
+        }
+        else
+        {
+            mSoftSprings.push_back( spring );
+        }
+    }
+    
+    for(int sI=0; sI<dirSpringCount; ++sI)
+    {
+        dirSpring = mDirSprings[sI];
+        mass1 = dirSpring->massPoint1();
+        mass2 = dirSpring->massPoint2();
+        
+        invMass = 0.0;
+        if( mass1->mass() > 0.0 ) invMass += 1.0 / mass1->mass();
+        if( mass2->mass() > 0.0 ) invMass += 1.0 / mass2->mass();
+        
+        if( dirSpring->dirStiffness() * invMass > mMultirateThreshold )
+        {
+            mStiffDirSprings.push_back( dirSpring );
+            stiffMassPoints.insert( mass1 );
+            stiffMassPoints.insert( mass2 );
+            
+            // the reaction torque of a dir spring acts on the root mass of the previous spring as well
+            Spring<Dim>* prevSpring = dirSpring->firstPrevSpring();
+            if( prevSpring != NULL ) stiffMassPoints.insert( prevSpring->massPoint1() );
+        }
+        else
+        {
+            mSoftDirSprings.push_back( dirSpring );
+        }
+    }
+    
+    // keep simulation order in both mass point partitions
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        if( stiffMassPoints.find( mMassPoints[pI] ) != stiffMassPoints.end() ) mStiffMassPoints.push_back( mMassPoints[pI] );
+        else mSoftMassPoints.push_back( mMassPoints[pI] );
+    }
+    
+    mStiffSlowForces.resize( mStiffMassPoints.size() );
+    
+    mPartitionVersion = mTopologyVersion;
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::collision() const
+{
+    return mCollision;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::collisionRadius() const
+{
+    return mCollisionRadius;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::collisionStiffness() const
+{
+    return mCollisionStiffness;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::collisionDamping() const
+{
+    return mCollisionDamping;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setCollision( bool pCollision )
+{
+    mCollision = pCollision;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setCollisionRadius( float pCollisionRadius )
+{
+    mCollisionRadius = pCollisionRadius;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setCollisionStiffness( float pCollisionStiffness )
+{
+    mCollisionStiffness = pCollisionStiffness;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setCollisionDamping( float pCollisionDamping )
+{
+    mCollisionDamping = pCollisionDamping;
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::springCollision() const
+{
+    return mSpringCollision;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::springCollisionRadius() const
+{
+    return mSpringCollisionRadius;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setSpringCollision( bool pSpringCollision )
+{
+    mSpringCollision = pSpringCollision;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setSpringCollisionRadius( float pSpringCollisionRadius )
+{
+    mSpringCollisionRadius = pSpringCollisionRadius;
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::longRange() const
+{
+    return mLongRange;
+}
+    
+template< unsigned int Dim >
+float
+Simulation<Dim>::longRangeTheta() const
+{
+    return mLongRangeTree.theta();
+}
+    
+template< unsigned int Dim >
+const PowerLawKernel<Dim>&
+Simulation<Dim>::longRangeKernel() const
+{
+    return mLongRangeKernel;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setLongRange( bool pLongRange )
+{
+    mLongRange = pLongRange;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setLongRangeTheta( float pLongRangeTheta )
+{
+    mLongRangeTree.setTheta( pLongRangeTheta );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setLongRangeKernel( const PowerLawKernel<Dim>& pLongRangeKernel )
+{
+    mLongRangeKernel = pLongRangeKernel;
+}
+    
+template< unsigned int Dim >
+const std::vector< MassPoint<Dim>* >&
+Simulation<Dim>::chainMassPoints() const
+{
+    return mChainMassPoints;
+}
+    
+template< unsigned int Dim >
+const std::vector< Spring<Dim>* >&
+Simulation<Dim>::chainSprings() const
+{
+    return mChainSprings;
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::setChain( const std::vector< MassPoint<Dim>* >& pMassPoints )
+{
+    // pMassPoints are the mass points of the chain in order, consecutive mass points must be connected by a spring
+    
+    int massCount = pMassPoints.size();
+    
+    mChainMassPoints.clear();
+    mChainSprings.clear();
+    
+    if( massCount != static_cast<int>( mMassPoints.size() ) ) return false;
+    
+    Spring<Dim>* chainSpring;
+    
+    for(int pI=0; pI<massCount - 1; ++pI)
+    {
+        const std::vector< Spring<Dim>* >& springs = pMassPoints[pI]->springs();
+        int massSpringCount = springs.size();
+        
+        chainSpring = NULL;
+        
+        for(int sI=0; sI<massSpringCount; ++sI)
+        {
+            if( springs[sI]->massPoint1() == pMassPoints[pI+1] || springs[sI]->massPoint2() == pMassPoints[pI+1] )
+            {
+                chainSpring = springs[sI];
+                break;
+            }
+        }
+        
+        if( chainSpring == NULL )
+        {
+            mChainSprings.clear();
+            return false;
+        }
+        
+        mChainSprings.push_back( chainSpring );
+    }
+    
+    mChainMassPoints = pMassPoints;
+    mChainVersion = mTopologyVersion;
+    
+    return true;
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::detectChain()
+{
+    // a chain has two end points with a single spring, all other mass points have exactly two springs
+    
+    int massCount = mMassPoints.size();
+    int springCount = mSprings.size();
+    
+    mChainMassPoints.clear();
+    mChainSprings.clear();
+    mChainVersion = mTopologyVersion;
+    
+    if( massCount < 2 || springCount != massCount - 1 ) return false;
+    
+    MassPoint<Dim>* mass = NULL;
+    
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        if( mMassPoints[pI]->springs().size() == 1 )
+        {
+            mass = mMassPoints[pI];
+            break;
+        }
+    }
+    
+    if( mass == NULL ) return false;
+    
+    Spring<Dim>* spring = NULL;
+    
+    while( true )
+    {
+        mChainMassPoints.push_back( mass );
+        
+        const std::vector< Spring<Dim>* >& springs = mass->springs();
+        if( springs.size() > 2 ) break;
+        
+        int massSpringCount = springs.size();
+        
+        Spring<Dim>* nextSpring = NULL;
+        for(int sI=0; sI<massSpringCount; ++sI) if( springs[sI] != spring ) nextSpring = springs[sI];
+        if( nextSpring == NULL ) break;
+        
+        spring = nextSpring;
+        mChainSprings.push_back( spring );
+        mass = spring->massPoint1() == mass ? spring->massPoint2() : spring->massPoint1();
+        
+        if( static_cast<int>( mChainMassPoints.size() ) > massCount ) break;
+    }
+    
+    if( static_cast<int>( mChainMassPoints.size() ) != massCount || static_cast<int>( mChainSprings.size() ) != springCount )
+    {
+        mChainMassPoints.clear();
+        mChainSprings.clear();
+        return false;
+    }
+    
+    return true;
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::diagnostics() const
+{
+    return mDiagnostics;
+}
+    
+template< unsigned int Dim >
+const Diagnostics<Dim>&
+Simulation<Dim>::lastDiagnostics() const
+{
+    return mLastDiagnostics;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setDiagnostics( bool pDiagnostics )
+{
+    mDiagnostics = pDiagnostics;
+    mStepDiagnostics.reset();
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::renderExport() const
+{
+    return mRenderExport;
+}
+    
+template< unsigned int Dim >
+const RenderBuffer<Dim>&
+Simulation<Dim>::renderBuffer() const
+{
+    return mRenderBuffer;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::setRenderExport( bool pRenderExport )
+{
+    mRenderExport = pRenderExport;
+    
+    if( mRenderExport == false )
+    {
+        mRenderBuffer.clear();
+        mRenderBufferVersion = std::numeric_limits<unsigned long>::max();
+    }
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateLength()
+{
+    updateLength( mSprings );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateLength( const std::vector< Spring<Dim>* >& pSprings )
+{
+    int springCount = pSprings.size();
+    
+    DAB_SPRING_PROFILE_SCOPE( LengthPhase, springCount );
+    DAB_SPRING_TRACE_SCOPE( "length" );
+    
+    // the same force as in the fused pass of updateForces()
+    LengthForce<Dim> lengthForce( mDiagnostics ? &mStepDiagnostics : NULL );
+    
+    for(int sI=0; sI<springCount; ++sI) lengthForce.spring( pSprings[sI] );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateAngle()
+{
+    // angles are only defined for two and three dimensions
+}
+
+template<>
+void
+Simulation<2>::updateAngle();
+
+template<>
+void
+Simulation<3>::updateAngle();
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateDir()
+{
+    updateDir( mDirSprings );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateDir( const std::vector< DirSpring<Dim>* >& )
+{
+    //TODO: for other dimensions than 2 and 3
+}
+
+template<>
+void
+Simulation<2>::updateDir( const std::vector< DirSpring<2>* >& pSprings );
+
+template<>
+void
+Simulation<3>::updateDir( const std::vector< DirSpring<3>* >& pSprings );
+
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateGravity()
+{
+    int massCount = mMassPoints.size();
+    int springCount = mSprings.size();
+    MassPoint<Dim>* mass;
+    
+    DAB_SPRING_PROFILE_SCOPE( GravityDampingPhase, massCount );
+    DAB_SPRING_TRACE_SCOPE( "gravity" );
+    
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        mass = mMassPoints[pI];
+        
+        //        // debug
+        //        if( mMassPoints.indexOf( mass ) == 0 ) std::cout << "Simulation<Dim>::updateGravity() mass " << mass << " add force  " << mGravity << "\n";
+        //        // debug done
+        
+        mass->addForce( mGravity );
+    }
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateDamping()
+{
+    int massCount = mMassPoints.size();
+    int springCount = mSprings.size();
+    MassPoint<Dim>* mass;
+    Eigen::Matrix<float, Dim, 1> force;
+    
+    DAB_SPRING_PROFILE_SCOPE( GravityDampingPhase, massCount );
+    DAB_SPRING_TRACE_SCOPE( "damping" );
+    
+    float damping_1 = mDamping * -1.0;
+    
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        mass = mMassPoints[pI];
+        force = mass->velocity() * damping_1;
+        
+        //        // debug
+        //        if( mMassPoints.indexOf( mass ) == 0 ) std::cout << "Simulation<Dim>::updateDamping() mass " << mass << " add force  " << force << "\n";
+        //        // debug done
+        
+        mass->addForce( force );
+    }
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateCollision()
+{
+    // mass points are spheres of radius mCollisionRadius
+    // overlapping mass points that are not connected by a spring repel each other
+    
+    if( mCollision == false ) return;
+    
+    DAB_SPRING_TRACE_SCOPE( "collision" );
+    
+    int massCount = mMassPoints.size();
+    
+    mCollisionPositions.resize( massCount );
+    for(int pI=0; pI<massCount; ++pI) mCollisionPositions[pI] = mMassPoints[pI]->position();
+    
+    float contactDistance = 2.0 * mCollisionRadius;
+    
+    mCollisionHash.setCellSize( contactDistance );
+    mCollisionHash.build( mCollisionPositions );
+    
+    auto contact = [this, contactDistance]( unsigned int pI, unsigned int pJ, float pDistance2 )
+    {
+        MassPoint<Dim>* mass1 = mMassPoints[pI];
+        MassPoint<Dim>* mass2 = mMassPoints[pJ];
+        
+        const std::vector< Spring<Dim>* >& springs = mass1->springs();
+        int massSpringCount = springs.size();
+        for(int sI=0; sI<massSpringCount; ++sI)
+        {
+            if( springs[sI]->massPoint1() == mass2 || springs[sI]->massPoint2() == mass2 ) return;
+        }
+        
+        float distance = std::sqrt( pDistance2 );
+        if( distance <= 0.0 ) return;
+        
+        Eigen::Matrix<float, Dim, 1> normal = ( mCollisionPositions[pJ] - mCollisionPositions[pI] ) / distance;
+        
+        float normalVelocity = ( mass2->velocity() - mass1->velocity() ).dot( normal );
+        Eigen::Matrix<float, Dim, 1> force = normal * ( mCollisionStiffness * ( contactDistance - distance ) - mCollisionDamping * normalVelocity );
+        
+        mass1->addForce( force * -1.0 );
+        mass2->addForce( force );
+    };
+    
+    mCollisionHash.pairs( mCollisionPositions, contactDistance, contact );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateSpringCollision()
+{
+    // springs are capsules of radius mSpringCollisionRadius
+    // the contact force acts at the closest points of two overlapping springs and is distributed onto their mass points
+    
+    if( mSpringCollision == false ) return;
+    
+    DAB_SPRING_TRACE_SCOPE( "spring_collision" );
+    
+    float contactDistance = 2.0 * mSpringCollisionRadius;
+    
+    // the hierarchy is only rebuilt when springs are added or removed, otherwise its bounds are refit
+    if( mSpringBVHVersion != mTopologyVersion )
+    {
+        mSpringBVH.build( mSprings, mSpringCollisionRadius );
+        mSpringBVHVersion = mTopologyVersion;
+    }
+    else
+    {
+        mSpringBVH.refit( mSpringCollisionRadius );
+    }
+    
+    auto contact = [this, contactDistance]( Spring<Dim>* pSpring1, Spring<Dim>* pSpring2 )
+    {
+        MassPoint<Dim>* mass11 = pSpring1->massPoint1();
+        MassPoint<Dim>* mass12 = pSpring1->massPoint2();
+        MassPoint<Dim>* mass21 = pSpring2->massPoint1();
+        MassPoint<Dim>* mass22 = pSpring2->massPoint2();
+        
+        const Eigen::Matrix<float, Dim, 1>& start1 = mass11->position();
+        const Eigen::Matrix<float, Dim, 1>& start2 = mass21->position();
+        Eigen::Matrix<float, Dim, 1> end1 = start1 + pSpring1->direction() * pSpring1->length();
+        Eigen::Matrix<float, Dim, 1> end2 = start2 + pSpring2->direction() * pSpring2->length();
+        
+        float param1;
+        float param2;
+        SegmentBVH<Dim>::closestPoints( start1, end1, start2, end2, param1, param2 );
+        
+        Eigen::Matrix<float, Dim, 1> offset = ( start2 + ( end2 - start2 ) * param2 ) - ( start1 + ( end1 - start1 ) * param1 );
+        float distance = offset.norm();
+        if( distance >= contactDistance || distance <= 0.0 ) return;
+        
+        Eigen::Matrix<float, Dim, 1> normal = offset / distance;
+        
+        Eigen::Matrix<float, Dim, 1> velocity1 = mass11->velocity() * ( 1.0 - param1 ) + mass12->velocity() * param1;
+        Eigen::Matrix<float, Dim, 1> velocity2 = mass21->velocity() * ( 1.0 - param2 ) + mass22->velocity() * param2;
+        float normalVelocity = ( velocity2 - velocity1 ).dot( normal );
+        
+        Eigen::Matrix<float, Dim, 1> force = normal * ( mCollisionStiffness * ( contactDistance - distance ) - mCollisionDamping * normalVelocity );
+        
+        mass11->addForce( force * -( 1.0 - param1 ) );
+        mass12->addForce( force * -param1 );
+        mass21->addForce( force * ( 1.0 - param2 ) );
+        mass22->addForce( force * param2 );
+    };
+    
+    mSpringBVH.pairs( contact );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateLongRange()
+{
+    if( mLongRange == false ) return;
+    
+    updateLongRange( mLongRangeKernel );
+}
+    
+template< unsigned int Dim >
+template<class Kernel>
+void
+Simulation<Dim>::updateLongRange( const Kernel& pKernel )
+{
+    // forces between all pairs of mass points, approximated with a Barnes-Hut tree that is rebuilt every call
+    // pKernel( offset, distanceSquared, charge ) returns the force of a charge at distance offset
+    
+    DAB_SPRING_TRACE_SCOPE( "long_range" );
+    
+    int massCount = mMassPoints.size();
+    
+    mLongRangePositions.resize( massCount );
+    for(int pI=0; pI<massCount; ++pI) mLongRangePositions[pI] = mMassPoints[pI]->position();
+    
+    mLongRangeTree.build( mLongRangePositions );
+    
+    for(int pI=0; pI<massCount; ++pI) mMassPoints[pI]->addForce( mLongRangeTree.force( mLongRangePositions, pI, pKernel ) );
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updatePressure()
+{
+    int bodyCount = mPressureBodies.size();
+    if( bodyCount == 0 ) return;
+    
+    DAB_SPRING_TRACE_SCOPE( "pressure" );
+    
+    for(int bI=0; bI<bodyCount; ++bI) mPressureBodies[bI]->update();
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updatePropulsion()
+{
+    // swimming forces, each mass point is propelled by the first spring that starts at it
+    // springs moving sideways through the medium push their first mass point backwards along the spring (propulsion)
+    // and are slowed down by the medium (viscosity)
+    
+    if( mPropulsion == false ) return;
+    
+    DAB_SPRING_TRACE_SCOPE( "propulsion" );
+    
+    if( mPropulsionVersion != mTopologyVersion )
+    {
+        std::unordered_set< MassPoint<Dim>* > propelledMassPoints;
+        int springCount = mSprings.size();
+        
+        mPropulsionSprings.clear();
+        
+        for(int sI=0; sI<springCount; ++sI)
+        {
+            if( propelledMassPoints.insert( mSprings[sI]->massPoint1() ).second ) mPropulsionSprings.push_back( mSprings[sI] );
+        }
+        
+        mPropulsionVersion = mTopologyVersion;
+    }
+    
+    int springCount = mPropulsionSprings.size();
+    
+    Spring<Dim>* spring;
+    MassPoint<Dim>* mass1;
+    MassPoint<Dim>* mass2;
+    Eigen::Matrix<float, Dim, 1> normDir;
+    Eigen::Matrix<float, Dim, 1> velDiff;
+    Eigen::Matrix<float, Dim, 1> velSum;
+    Eigen::Matrix<float, Dim, 1> normN;
+    Eigen::Matrix<float, Dim, 1> propForce;
+    Eigen::Matrix<float, Dim, 1> dampForce;
+    float springLength;
+    float velLength;
+    float velDiffLength;
+    float velSumLength;
+    float normLength;
+    float propAmount;
+    float dampAmount;
+    
+    for(int sI=0; sI<springCount; ++sI)
+    {
+        spring = mPropulsionSprings[sI];
+        
+        springLength = spring->length();
+        if( springLength < 0.0001 ) continue;
+        
+        mass1 = spring->massPoint1();
+        mass2 = spring->massPoint2();
+        
+        const Eigen::Matrix<float, Dim, 1>& vel = mass1->velocity();
+        
+        velDiff = vel - mass2->velocity();
+        velDiffLength = velDiff.norm();
+        if( velDiffLength < 0.0001 ) continue;
+        
+        velSum = vel + mass2->velocity();
+        velSumLength = velSum.norm();
+        if( velSumLength < 0.0001 ) continue;
+        
+        velLength = vel.norm();
+        normDir = spring->direction();
+        
+        // propulsion, normN is the component of the relative velocity perpendicular to the spring
+        normN = velDiff - normDir * normDir.dot( velDiff );
+        normLength = normN.norm();
+        
+        propAmount = normLength * springLength;
+        propForce = normDir * propAmount * mPropulsionScale * -1.0;
+        
+        // viscosity, normN is the direction of the velocity perpendicular to the spring
+        dampForce = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+        
+        if( velLength > 0.0001 )
+        {
+            normN = vel - normDir * normDir.dot( vel );
+            normLength = normN.norm();
+            
+            if( normLength > 0.0001 )
+            {
+                normN /= normLength;
+                
+                dampAmount = std::abs( velSum.dot( normN ) ) / velSumLength * velLength * springLength;
+                dampForce = normN * dampAmount * mViscosityScale;
+                
+                dampAmount = normLength * springLength;
+                dampForce += normDir * dampAmount * mViscosityScale;
+            }
+        }
+        
+        mass1->addForce( propForce - dampForce );
+    }
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::updateWind()
+{
+    // the wind grid is refit and evaluated once per simulation step at the simulated time, multirate sub steps reuse it
+    // each mass point is dragged towards the local wind velocity
+    
+    if( mWind == false ) return;
+    
+    int massCount = mMassPoints.size();
+    if( massCount == 0 ) return;
+    
+    DAB_SPRING_TRACE_SCOPE( "wind" );
+    
+    if( mWindStep != mSimStep )
+    {
+        Eigen::Matrix<float, Dim, 1> minCorner = mMassPoints[0]->position();
+        Eigen::Matrix<float, Dim, 1> maxCorner = minCorner;
+        
+        for(int pI=1; pI<massCount; ++pI)
+        {
+            minCorner = minCorner.cwiseMin( mMassPoints[pI]->position() );
+            maxCorner = maxCorner.cwiseMax( mMassPoints[pI]->position() );
+        }
+        
+        mWindField.update( mSimTime, minCorner, maxCorner );
+        mWindStep = mSimStep;
+    }
+    
+    MassPoint<Dim>* mass;
+    
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        mass = mMassPoints[pI];
+        if( mass->drag() == 0.0 ) continue;
+        
+        mass->addForce( ( mWindField.sample( mass->position() ) - mass->velocity() ) * mass->drag() );
+    }
+}
+    
+template< unsigned int Dim >
+template<class... Terms>
+void
+Simulation<Dim>::updateForceTerms( const Terms&... pTerms )
+{
+    updateForceTerms( mMassPoints, mSprings, pTerms... );
+}
+    
+template< unsigned int Dim >
+template<class... Terms>
+void
+Simulation<Dim>::updateForceTerms( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings, const Terms&... pTerms )
+{
+    // all terms are applied within a single pass over the mass points and a single pass over the springs
+    
+    if( ForceTerms::any( { bool( Terms::sPointTerm )... } ) )
+    {
+        int massCount = pMassPoints.size();
+        
+        DAB_SPRING_PROFILE_SCOPE( GravityDampingPhase, massCount );
+        DAB_SPRING_TRACE_SCOPE( "point_terms" );
+        
+        for(int pI=0; pI<massCount; ++pI) ForceTerms::point( pMassPoints[pI], pTerms... );
+    }
+    
+    if( ForceTerms::any( { bool( Terms::sSpringTerm )... } ) )
+    {
+        int springCount = pSprings.size();
+        
+        DAB_SPRING_PROFILE_SCOPE( LengthPhase, springCount );
+        DAB_SPRING_TRACE_SCOPE( "spring_terms" );
+        
+        for(int sI=0; sI<springCount; ++sI) ForceTerms::spring( pSprings[sI], pTerms... );
+    }
+}
+    
+template< unsigned int Dim >
+template<class... Terms>
+void
+Simulation<Dim>::updateForces( const Terms&... pTerms )
+{
+    // custom force terms are fused with the length, gravity and damping forces into the same passes
+    
+    DAB_SPRING_TRACE_SCOPE( "forces" );
+    
+    updateForceTerms( LengthForce<Dim>( mDiagnostics ? &mStepDiagnostics : NULL ), GravityForce<Dim>( mGravity ), DampingForce<Dim>( mDamping ), pTerms... );
+    updateAngle();
+    updateDir();
+    updatePropulsion();
+    updateWind();
+    updateCollision();
+    updateSpringCollision();
+    updateLongRange();
+    updatePressure();
+}
+    
+template< unsigned int Dim >
+template<class Policy>
+void
+Simulation<Dim>::solve()
+{
+    PolicySolver<Policy> solver( mTimeStep );
+    solve( solver, mMassPoints );
+}
+    
+template< unsigned int Dim >
+template<class Solver>
+void
+Simulation<Dim>::solve( Solver& pSolver )
+{
+    solve( pSolver, mMassPoints );
+}
+    
+template< unsigned int Dim >
+template<class Solver>
+void
+Simulation<Dim>::solve( Solver& pSolver, const std::vector< MassPoint<Dim>* >& pMassPoints )
+{
+    //std::cout << "Simulation<Dim>::solve( Solver& pSolver ) begin\n";
+    
+    int massCount = pMassPoints.size();
+    MassPoint<Dim>* mass;
+    
+    DAB_SPRING_PROFILE_SCOPE( IntegrationPhase, massCount );
+    DAB_SPRING_TRACE_SCOPE( "integration" );
+    
+    // multirate sub steps integrate with fractions of the step, the step time is the largest time step of a step
+    mStepTime = std::max( mStepTime, pSolver.timeStep() );
+    
+    // numerical integration
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        mass = pMassPoints[pI];
+        
+        Eigen::Matrix<float, Dim,1>& mpForce = mass->force();
+        
+        // nan values compare unequal to themselves, select avoids a branch per component
+        mpForce = ( mpForce.array() == mpForce.array() ).select( mpForce, 0.0f );
+        
+        //if(pI == 0) std::cout << "point " << pI << " mass " << mass << " pos " << mass->position() << " force  " << mass->force() << "\n";
+
+        float mpMass = mass->mass();
+        Eigen::Matrix<float, Dim, 1>& mpPosition = mass->position();
+        Eigen::Matrix<float, Dim, 1>& mpVelocity = mass->velocity();
+        Eigen::Matrix<float, Dim, 1>& mpBackupPosition = mass->backupPosition();
+        Eigen::Matrix<float, Dim, 1>& mpBackupVelocity = mass->backupVelocity();
+        
+        Eigen::Matrix<float, Dim, 1> scaledForce = mpForce / mpMass;
+        
+        if( mpMass > 0.0 ) pSolver.template solve<Dim>( mpPosition, mpVelocity, scaledForce, mpBackupPosition, mpBackupVelocity );
+        if( mDiagnostics && mpMass > 0.0 ) mStepDiagnostics.addMassPoint( mpMass, mpVelocity );
+
+        
+        // is nan check
+        mpBackupPosition = ( mpBackupPosition.array() == mpBackupPosition.array() ).select( mpBackupPosition, mpPosition );
+        mpBackupVelocity = ( mpBackupVelocity.array() == mpBackupVelocity.array() ).select( mpBackupVelocity, mpVelocity );
+    }
+    
+    //std::cout << "Simulation<Dim>::solve( Solver& pSolver ) end\n";
+}
+    
+template< unsigned int Dim >
+template<class Solver, class... Terms>
+void
+Simulation<Dim>::solveMultirate( Solver& pSolver, const Terms&... pTerms )
+{
+    // forces of soft springs, gravity and damping are evaluated once per step and held constant while
+    // the stiff springs are re-evaluated and their mass points integrated with smaller sub steps
+    // there are mMultirateSubSteps sub steps, or with an adaptive time step as many as the stiff springs need to remain stable
+    
+    DAB_SPRING_TRACE_SCOPE( "multirate" );
+    
+    if( mPartitionVersion != mTopologyVersion ) updatePartition();
+    
+    // custom terms act on the stiff springs as well, but like all slow forces only once per step
+    updateForceTerms( mMassPoints, mSoftSprings, LengthForce<Dim>( mDiagnostics ? &mStepDiagnostics : NULL ), GravityForce<Dim>( mGravity ), DampingForce<Dim>( mDamping ), pTerms... );
+    if( ForceTerms::any( { bool( Terms::sSpringTerm )... } ) ) updateForceTerms( std::vector< MassPoint<Dim>* >(), mStiffSprings, pTerms... );
+    updateAngle();
+    updateDir( mSoftDirSprings );
+    updatePropulsion();
+    updateWind();
+    updateCollision();
+    updateSpringCollision();
+    updateLongRange();
+    updatePressure();
+    
+    solve( pSolver, mSoftMassPoints );
+    
+    int stiffMassCount = mStiffMassPoints.size();
+    int stiffSpringCount = mStiffSprings.size();
+    int stiffDirSpringCount = mStiffDirSprings.size();
+    
+    if( stiffMassCount == 0 ) return;
+    
+    MassPoint<Dim>* mass;
+    
+    for(int pI=0; pI<stiffMassCount; ++pI) mStiffSlowForces[pI] = mStiffMassPoints[pI]->force();
+    
+    float timeStep = pSolver.timeStep();
+    unsigned int stiffSubStepCount = mMultirateSubSteps;
+    
+    if( mAdaptiveTimeStep )
+    {
+        float stiffTimeStep = stableTimeStep( mStiffMassPoints, mStiffSprings, mStiffDirSprings, NULL );
+        
+        stiffSubStepCount = 1;
+        if( stiffTimeStep > 0.0 && stiffTimeStep < timeStep ) stiffSubStepCount = static_cast<unsigned int>( std::ceil( std::min( timeStep / stiffTimeStep, static_cast<float>( std::numeric_limits<unsigned int>::max() ) ) ) );
+        
+        if( stiffSubStepCount > mMaxSubSteps ) mSubStepClamped = true;
+        stiffSubStepCount = std::min( stiffSubStepCount, mMaxSubSteps );
+    }
+    
+    pSolver.setTimeStep( timeStep / static_cast<float>( stiffSubStepCount ) );
+    
+    // stiff springs and mass points only contribute to the diagnostics of the step with their first sub step
+    bool diagnostics = mDiagnostics;
+    
+    for(unsigned int subStep=0; subStep<stiffSubStepCount; ++subStep)
+    {
+        if( subStep > 0 )
+        {
+            mDiagnostics = false;
+            
+            for(int pI=0; pI<stiffMassCount; ++pI)
+            {
+                mass = mStiffMassPoints[pI];
+                mass->position() = mass->backupPosition();
+                mass->velocity() = mass->backupVelocity();
+            }
+            for(int sI=0; sI<stiffSpringCount; ++sI) mStiffSprings[sI]->update();
+            for(int sI=0; sI<stiffDirSpringCount; ++sI) mStiffDirSprings[sI]->update();
+        }
+        
+        for(int pI=0; pI<stiffMassCount; ++pI) mStiffMassPoints[pI]->force() = mStiffSlowForces[pI];
+        
+        updateLength( mStiffSprings );
+        updateDir( mStiffDirSprings );
+        
+        solve( pSolver, mStiffMassPoints );
+    }
+    
+    mDiagnostics = diagnostics;
+    pSolver.setTimeStep( timeStep );
+}
+    
+template< unsigned int Dim >
+template<class Policy, class... Terms>
+unsigned int
+Simulation<Dim>::step( float pFrameTime, const Terms&... pTerms )
+{
+    PolicySolver<Policy> solver( mTimeStep );
+    return step( solver, pFrameTime, pTerms... );
+}
+    
+template< unsigned int Dim >
+bool
+Simulation<Dim>::solveChain( ChainSolver& pSolver )
+{
+    // the chain solver handles one-dimensional springs only, other dimensions always take the explicit fallback
+    // of Simulation<1>::solveChain(): spring and damping forces are added and the mass points integrated with leapfrog
+    
+    updateLength();
+    updateDamping();
+    
+    PolicySolver<LeapFrogPolicy> solver( pSolver.timeStep() );
+    solve( solver );
+    
+    return false;
+}
+    
+template<>
+bool
+Simulation<1>::solveChain( ChainSolver& pSolver );
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::resolveObstacles()
+{
+    // to be called after solve(), moves integrated positions that penetrate an obstacle back onto its surface
+    
+    int obstacleCount = mObstacles.size();
+    if( obstacleCount == 0 ) return;
+    
+    DAB_SPRING_TRACE_SCOPE( "obstacles" );
+    
+    for(int oI=0; oI<obstacleCount; ++oI) mObstacles[oI]->resolve( mMassPoints );
+}
+    
+template< unsigned int Dim >
+template<class Solver, class... Terms>
+unsigned int
+Simulation<Dim>::step( Solver& pSolver, float pFrameTime, const Terms&... pTerms )
+{
+    // pTerms are custom force terms that are fused into the force passes of every sub step, see updateForces()
+    
+    DAB_SPRING_TRACE_SCOPE( "step" );
+    
+    float solverTimeStep = pSolver.timeStep();
+    
+    // the partition has to be current for stableTimeStep() to leave out the stiff springs
+    if( mMultirate && mPartitionVersion != mTopologyVersion ) updatePartition();
+    
+    float subStepTime = mAdaptiveTimeStep ? stableTimeStep() : solverTimeStep;
+    
+    unsigned int subStepCount = 1;
+    if( subStepTime > 0.0 && subStepTime < pFrameTime ) subStepCount = static_cast<unsigned int>( std::ceil( std::min( pFrameTime / subStepTime, static_cast<float>( std::numeric_limits<unsigned int>::max() ) ) ) );
+    
+    // with too few sub steps allowed the sub step exceeds the stable time step, this is reported by subStepClamped()
+    // solveMultirate() reports the same for the sub steps of the stiff springs
+    mSubStepClamped = subStepCount > mMaxSubSteps;
+    subStepCount = std::min( subStepCount, mMaxSubSteps );
+    
+    pSolver.setTimeStep( pFrameTime / static_cast<float>( subStepCount ) );
+    
+    mStepping = true;
+    
+    for(unsigned int sI=0; sI<subStepCount; ++sI)
+    {
+        if( mMultirate )
+        {
+            solveMultirate( pSolver, pTerms... );
+        }
+        else
+        {
+            updateForces( pTerms... );
+            solve( pSolver );
+        }
+        
+        resolveObstacles();
+        update();
+    }
+    
+    // the profiler sums the phases over all sub steps of a frame
+    mStepping = false;
+    DAB_SPRING_PROFILE_END_STEP();
+    
+    pSolver.setTimeStep( solverTimeStep );
+    mSubStepCount = subStepCount;
+    
+    return subStepCount;
+}
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::update()
+{
+    //    std::cout << "SpringSim gravity " << mGravity << " damping " << mDamping << " propScale " << mPropulsionScale << " visScale " << mViscosityScale << "\n";
+    
+    int massCount = mMassPoints.size();
+    int springCount = mSprings.size();
+    
+    //std::cout << "massCount " << massCount << " springCount " << springCount << "\n";
+    
+    DAB_SPRING_TRACE_SCOPE( "update" );
+    
+    // refresh backups
+    {
+        DAB_SPRING_PROFILE_SCOPE( BackupRefreshPhase, massCount );
+        DAB_SPRING_TRACE_SCOPE( "backup_refresh" );
+        
+        for(int pI=0; pI<massCount; ++pI)
+        {
+            mMassPoints[pI]->update();
+            
+            //        // debug
+            //        std::cout << "mp " << pI << " : " << mMassPoints[pI];
+            //        const QVector< Spring<Dim>* >& springs = mMassPoints[pI]->springs();
+            //        for(int sI=0; sI<springs.size(); ++sI) std::cout << " sI " << sI << " : " << springs[sI];
+            //        std::cout << "\n";
+            //        // debug done
+            
+        }
+    }
+    
+    // refresh spring geometry
+    {
+        DAB_SPRING_PROFILE_SCOPE( SpringGeometryPhase, springCount );
+        DAB_SPRING_TRACE_SCOPE( "spring_geometry" );
+        
+        for(int sI=0; sI<springCount; ++sI)
+        {
+            mSprings[sI]->update();
+            
+            //        // debug
+            //        std::cout << "sI " << sI << " : " << mSprings[sI] << " mp1 " << mSprings[sI]->massPoint1() << " mp2 " << mSprings[sI]->massPoint2() << "\n";
+            //        // debug done
+        }
+    }
+    
+    // refresh render buffers, the index buffer is only rebuilt when springs or mass points have been added or removed
+    if( mRenderExport )
+    {
+        DAB_SPRING_TRACE_SCOPE( "render_buffer" );
+        
+        if( mRenderBufferVersion != mTopologyVersion )
+        {
+            mRenderBuffer.build( mMassPoints, mSprings );
+            mRenderBufferVersion = mTopologyVersion;
+        }
+        else
+        {
+            mRenderBuffer.refresh();
+        }
+    }
+    
+    // within step() the profiler step ends after the last sub step
+    if( !mStepping )
+    {
+        DAB_SPRING_PROFILE_END_STEP();
+    }
+    
+    if( mDiagnostics )
+    {
+        mLastDiagnostics = mStepDiagnostics;
+        mLastDiagnostics.mSimStep = mSimStep;
+        mStepDiagnostics.reset();
+    }
+    
+    mSimTime += mStepTime;
+    mStepTime = 0.0;
+    mSimStep++;
+}
+    
+#ifdef DAB_SPRING_PROFILE
+template< unsigned int Dim >
+const Profiler&
+Simulation<Dim>::profiler() const
+{
+    return mProfiler;
+}
+    
+template< unsigned int Dim >
+Profiler&
+Simulation<Dim>::profiler()
+{
+    return mProfiler;
+}
+#endif
+    
+template< unsigned int Dim >
+void
+Simulation<Dim>::clear()
+{
+    mExternalForces.clear();
+	mSprings.clear();
+	mAngledSprings.clear();
 	mDirSprings.clear();
 	mMassPoints.clear();
+    mMassPointSet.clear();
+    mObstacles.clear();
+    mPressureBodies.clear();
+    mRenderBuffer.clear();
+    
+    mTopologyVersion++;
 }
     
 template< unsigned int Dim >
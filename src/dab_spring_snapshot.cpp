@@ -0,0 +1,7 @@
+/** \file dab_spring_snapshot.cpp
+*/
+
+#include "dab_spring_snapshot.h"
+
+using namespace dab;
+using namespace dab::spring;
@@ -0,0 +1,507 @@
+/** \file dab_spring_snapshot.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <Eigen/Dense>
+#include "dab_spring_simulation.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark Snapshot Definition
+
+// binary snapshot of the topology, parameters and state of a simulation
+// the file consists of a header, a parameter record, all mass point records and all spring records
+// records have a fixed size and native byte order, a file can therefore be read in one pass or memory mapped
+// mass points and springs created by load() are owned by the snapshot and have to outlive their use in the simulation
+// not stored are external forces, obstacles, pressure bodies, the wind field configuration and custom long range kernels
+// matches() compares a simulation with the loaded snapshot, for instance to check a save and load round trip
+
+template< unsigned int Dim >
+class Snapshot
+{
+public:
+    static const uint32_t sVersion = 1;
+
+    enum SpringType
+    {
+        PlainSpring,
+        AngledSpringType,
+        DirSpringType
+    };
+
+    struct Header
+    {
+        char mMagic[4];
+        uint32_t mByteOrder;
+        uint32_t mVersion;
+        uint32_t mDim;
+        uint32_t mMassPointCount;
+        uint32_t mSpringCount;
+    };
+
+    struct Parameters
+    {
+        float mGravity[Dim];
+        float mDamping;
+        float mViscosityScale;
+        float mPropulsionScale;
+        float mTimeStep;
+        float mTimeStepSafety;
+        float mMaxStrainPerStep;
+        uint32_t mMaxSubSteps;
+        float mMultirateThreshold;
+        uint32_t mMultirateSubSteps;
+        float mCollisionRadius;
+        float mCollisionStiffness;
+        float mCollisionDamping;
+        float mSpringCollisionRadius;
+        float mLongRangeTheta;
+        uint32_t mFlags;
+    };
+
+    struct MassPointRecord
+    {
+        float mMass;
+        float mDrag;
+        float mPosition[Dim];
+        float mVelocity[Dim];
+    };
+
+    struct SpringRecord
+    {
+        uint32_t mType;
+        uint32_t mMassPoint1;
+        uint32_t mMassPoint2;
+        float mRestLength;
+        float mStiffness;
+        float mDamping;
+        float mRestAngle1;
+        float mRestAngle2;
+        float mRestDir[Dim];
+        float mAngleStiffness;
+    };
+
+    Snapshot();
+    ~Snapshot();
+
+    const std::vector< MassPoint<Dim>* >& massPoints() const;
+    const std::vector< Spring<Dim>* >& springs() const;
+
+    static bool save( const Simulation<Dim>& pSimulation, const std::string& pFileName );
+    bool load( const std::string& pFileName );
+    bool load( const char* pData, size_t pSize );
+    void addTo( Simulation<Dim>& pSimulation ) const;
+    bool matches( const Simulation<Dim>& pSimulation ) const;
+    void clear();
+
+protected:
+    enum Flag
+    {
+        PropulsionFlag = 1 << 0,
+        WindFlag = 1 << 1,
+        AdaptiveTimeStepFlag = 1 << 2,
+        MultirateFlag = 1 << 3,
+        CollisionFlag = 1 << 4,
+        SpringCollisionFlag = 1 << 5,
+        LongRangeFlag = 1 << 6
+    };
+
+    static const uint32_t sByteOrder = 0x01020304;
+
+    Parameters mParameters;
+    std::vector< MassPoint<Dim>* > mMassPoints;
+    std::vector< Spring<Dim>* > mSprings;
+    std::vector< uint32_t > mSpringTypes;
+
+    static Parameters parameters( const Simulation<Dim>& pSimulation );
+    static bool records( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings, std::vector< MassPointRecord >& pMassRecords, std::vector< SpringRecord >& pSpringRecords );
+};
+
+typedef Snapshot<2>  Snapshot2D;
+typedef Snapshot<3>  Snapshot3D;
+
+#pragma mark Snapshot Implementation
+
+template< unsigned int Dim >
+Snapshot<Dim>::Snapshot()
+{
+    std::memset( &mParameters, 0, sizeof( Parameters ) );
+}
+
+template< unsigned int Dim >
+Snapshot<Dim>::~Snapshot()
+{
+    clear();
+}
+
+template< unsigned int Dim >
+const std::vector< MassPoint<Dim>* >&
+Snapshot<Dim>::massPoints() const
+{
+    return mMassPoints;
+}
+
+template< unsigned int Dim >
+const std::vector< Spring<Dim>* >&
+Snapshot<Dim>::springs() const
+{
+    return mSprings;
+}
+
+template< unsigned int Dim >
+bool
+Snapshot<Dim>::save( const Simulation<Dim>& pSimulation, const std::string& pFileName )
+{
+    Header header;
+    std::memcpy( header.mMagic, "DABS", 4 );
+    header.mByteOrder = sByteOrder;
+    header.mVersion = sVersion;
+    header.mDim = Dim;
+    header.mMassPointCount = pSimulation.massPoints().size();
+    header.mSpringCount = pSimulation.springs().size();
+
+    Parameters parameters = Snapshot<Dim>::parameters( pSimulation );
+
+    std::vector< MassPointRecord > massRecords;
+    std::vector< SpringRecord > springRecords;
+
+    if( records( pSimulation.massPoints(), pSimulation.springs(), massRecords, springRecords ) == false ) return false;
+
+    std::ofstream file( pFileName, std::ios::binary );
+
+    if( file.is_open() == false )
+    {
+        std::cout << "Snapshot: could not open " << pFileName << "\n";
+        return false;
+    }
+
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( Header ) );
+    file.write( reinterpret_cast< const char* >( &parameters ), sizeof( Parameters ) );
+    file.write( reinterpret_cast< const char* >( massRecords.data() ), massRecords.size() * sizeof( MassPointRecord ) );
+    file.write( reinterpret_cast< const char* >( springRecords.data() ), springRecords.size() * sizeof( SpringRecord ) );
+
+    return file.good();
+}
+
+template< unsigned int Dim >
+bool
+Snapshot<Dim>::load( const std::string& pFileName )
+{
+    std::ifstream file( pFileName, std::ios::binary | std::ios::ate );
+
+    if( file.is_open() == false )
+    {
+        std::cout << "Snapshot: could not open " << pFileName << "\n";
+        return false;
+    }
+
+    size_t size = file.tellg();
+    std::vector< char > data( size );
+
+    file.seekg( 0 );
+    file.read( data.data(), size );
+
+    if( file.good() == false )
+    {
+        std::cout << "Snapshot: could not read " << pFileName << "\n";
+        return false;
+    }
+
+    return load( data.data(), size );
+}
+
+template< unsigned int Dim >
+bool
+Snapshot<Dim>::load( const char* pData, size_t pSize )
+{
+    // pData may point into a memory mapped file, records are only read, never referenced afterwards
+
+    clear();
+
+    if( pSize < sizeof( Header ) + sizeof( Parameters ) )
+    {
+        std::cout << "Snapshot: data too short\n";
+        return false;
+    }
+
+    Header header;
+    std::memcpy( &header, pData, sizeof( Header ) );
+
+    if( std::memcmp( header.mMagic, "DABS", 4 ) != 0 || header.mByteOrder != sByteOrder )
+    {
+        std::cout << "Snapshot: not a snapshot or written with a different byte order\n";
+        return false;
+    }
+    if( header.mVersion != sVersion || header.mDim != Dim )
+    {
+        std::cout << "Snapshot: version " << header.mVersion << " dimension " << header.mDim << " does not match version " << sVersion << " dimension " << Dim << "\n";
+        return false;
+    }
+
+    size_t massOffset = sizeof( Header ) + sizeof( Parameters );
+    size_t springOffset = massOffset + static_cast<size_t>( header.mMassPointCount ) * sizeof( MassPointRecord );
+
+    if( pSize < springOffset + static_cast<size_t>( header.mSpringCount ) * sizeof( SpringRecord ) )
+    {
+        std::cout << "Snapshot: data too short for " << header.mMassPointCount << " mass points and " << header.mSpringCount << " springs\n";
+        return false;
+    }
+
+    std::memcpy( &mParameters, pData + sizeof( Header ), sizeof( Parameters ) );
+
+    mMassPoints.reserve( header.mMassPointCount );
+    mSprings.reserve( header.mSpringCount );
+    mSpringTypes.reserve( header.mSpringCount );
+
+    MassPointRecord massRecord;
+    Eigen::Matrix<float, Dim, 1> vector;
+
+    for(unsigned int pI=0; pI<header.mMassPointCount; ++pI)
+    {
+        std::memcpy( &massRecord, pData + massOffset + pI * sizeof( MassPointRecord ), sizeof( MassPointRecord ) );
+
+        for(unsigned int d=0; d<Dim; ++d) vector[d] = massRecord.mPosition[d];
+        MassPoint<Dim>* mass = new MassPoint<Dim>( massRecord.mMass, vector );
+
+        for(unsigned int d=0; d<Dim; ++d) vector[d] = massRecord.mVelocity[d];
+        mass->setVelocity( vector );
+        mass->setDrag( massRecord.mDrag );
+
+        mMassPoints.push_back( mass );
+    }
+
+    SpringRecord springRecord;
+
+    for(unsigned int sI=0; sI<header.mSpringCount; ++sI)
+    {
+        std::memcpy( &springRecord, pData + springOffset + sI * sizeof( SpringRecord ), sizeof( SpringRecord ) );
+
+        if( springRecord.mMassPoint1 >= header.mMassPointCount || springRecord.mMassPoint2 >= header.mMassPointCount )
+        {
+            std::cout << "Snapshot: spring " << sI << " mass point index out of range\n";
+            clear();
+            return false;
+        }
+
+        MassPoint<Dim>* mass1 = mMassPoints[springRecord.mMassPoint1];
+        MassPoint<Dim>* mass2 = mMassPoints[springRecord.mMassPoint2];
+
+        if( springRecord.mType == AngledSpringType )
+        {
+            mSprings.push_back( new AngledSpring<Dim>( mass1, mass2, springRecord.mRestLength, springRecord.mStiffness, springRecord.mRestAngle1, springRecord.mRestAngle2, springRecord.mAngleStiffness, springRecord.mDamping ) );
+            mSpringTypes.push_back( AngledSpringType );
+        }
+        else if( springRecord.mType == DirSpringType )
+        {
+            for(unsigned int d=0; d<Dim; ++d) vector[d] = springRecord.mRestDir[d];
+
+            mSprings.push_back( new DirSpring<Dim>( mass1, mass2, springRecord.mRestLength, springRecord.mStiffness, vector, springRecord.mAngleStiffness, springRecord.mDamping ) );
+            mSpringTypes.push_back( DirSpringType );
+        }
+        else
+        {
+            mSprings.push_back( new Spring<Dim>( mass1, mass2, springRecord.mRestLength, springRecord.mStiffness, springRecord.mDamping ) );
+            mSpringTypes.push_back( PlainSpring );
+        }
+    }
+
+    // constructors only update the base spring, derived springs derive their reference frames from the spring they follow
+    for(auto spring : mSprings) spring->update();
+
+    return true;
+}
+
+template< unsigned int Dim >
+void
+Snapshot<Dim>::addTo( Simulation<Dim>& pSimulation ) const
+{
+    Eigen::Matrix<float, Dim, 1> gravity;
+    for(unsigned int d=0; d<Dim; ++d) gravity[d] = mParameters.mGravity[d];
+
+    pSimulation.setGravity( gravity );
+    pSimulation.setDamping( mParameters.mDamping );
+    pSimulation.setViscosityScale( mParameters.mViscosityScale );
+    pSimulation.setPropulsionScale( mParameters.mPropulsionScale );
+    pSimulation.setTimeStep( mParameters.mTimeStep );
+    pSimulation.setTimeStepSafety( mParameters.mTimeStepSafety );
+    pSimulation.setMaxStrainPerStep( mParameters.mMaxStrainPerStep );
+    pSimulation.setMaxSubSteps( mParameters.mMaxSubSteps );
+    pSimulation.setMultirateThreshold( mParameters.mMultirateThreshold );
+    pSimulation.setMultirateSubSteps( mParameters.mMultirateSubSteps );
+    pSimulation.setCollisionRadius( mParameters.mCollisionRadius );
+    pSimulation.setCollisionStiffness( mParameters.mCollisionStiffness );
+    pSimulation.setCollisionDamping( mParameters.mCollisionDamping );
+    pSimulation.setSpringCollisionRadius( mParameters.mSpringCollisionRadius );
+    pSimulation.setLongRangeTheta( mParameters.mLongRangeTheta );
+    pSimulation.setPropulsion( mParameters.mFlags & PropulsionFlag );
+    pSimulation.setWind( mParameters.mFlags & WindFlag );
+    pSimulation.setAdaptiveTimeStep( mParameters.mFlags & AdaptiveTimeStepFlag );
+    pSimulation.setMultirate( mParameters.mFlags & MultirateFlag );
+    pSimulation.setCollision( mParameters.mFlags & CollisionFlag );
+    pSimulation.setSpringCollision( mParameters.mFlags & SpringCollisionFlag );
+    pSimulation.setLongRange( mParameters.mFlags & LongRangeFlag );
+
+    // mass points first so that they keep their order, adding the springs then only finds them
+    pSimulation.reserve( pSimulation.massPoints().size() + mMassPoints.size(), pSimulation.springs().size() + mSprings.size() );
+
+    for(auto mass : mMassPoints) pSimulation.addMassPoint( mass );
+
+    int springCount = mSprings.size();
+
+    for(int sI=0; sI<springCount; ++sI)
+    {
+        if( mSpringTypes[sI] == AngledSpringType ) pSimulation.addSpring( static_cast< AngledSpring<Dim>* >( mSprings[sI] ) );
+        else if( mSpringTypes[sI] == DirSpringType ) pSimulation.addSpring( static_cast< DirSpring<Dim>* >( mSprings[sI] ) );
+        else pSimulation.addSpring( mSprings[sI] );
+    }
+}
+
+template< unsigned int Dim >
+bool
+Snapshot<Dim>::matches( const Simulation<Dim>& pSimulation ) const
+{
+    // records are compared bitwise, they are fully initialized and have no padding
+
+    Parameters parameters = Snapshot<Dim>::parameters( pSimulation );
+    if( std::memcmp( &parameters, &mParameters, sizeof( Parameters ) ) != 0 ) return false;
+
+    std::vector< MassPointRecord > massRecords;
+    std::vector< SpringRecord > springRecords;
+    std::vector< MassPointRecord > loadedMassRecords;
+    std::vector< SpringRecord > loadedSpringRecords;
+
+    if( records( pSimulation.massPoints(), pSimulation.springs(), massRecords, springRecords ) == false ) return false;
+    if( records( mMassPoints, mSprings, loadedMassRecords, loadedSpringRecords ) == false ) return false;
+
+    if( massRecords.size() != loadedMassRecords.size() || springRecords.size() != loadedSpringRecords.size() ) return false;
+    if( massRecords.size() > 0 && std::memcmp( massRecords.data(), loadedMassRecords.data(), massRecords.size() * sizeof( MassPointRecord ) ) != 0 ) return false;
+    if( springRecords.size() > 0 && std::memcmp( springRecords.data(), loadedSpringRecords.data(), springRecords.size() * sizeof( SpringRecord ) ) != 0 ) return false;
+
+    return true;
+}
+
+template< unsigned int Dim >
+void
+Snapshot<Dim>::clear()
+{
+    deleteSprings( mMassPoints, mSprings );
+
+    mMassPoints.clear();
+    mSprings.clear();
+    mSpringTypes.clear();
+}
+
+template< unsigned int Dim >
+typename Snapshot<Dim>::Parameters
+Snapshot<Dim>::parameters( const Simulation<Dim>& pSimulation )
+{
+    Parameters parameters;
+    for(unsigned int d=0; d<Dim; ++d) parameters.mGravity[d] = pSimulation.gravity()[d];
+    parameters.mDamping = pSimulation.damping();
+    parameters.mViscosityScale = pSimulation.viscosityScale();
+    parameters.mPropulsionScale = pSimulation.propulsionScale();
+    parameters.mTimeStep = pSimulation.timeStep();
+    parameters.mTimeStepSafety = pSimulation.timeStepSafety();
+    parameters.mMaxStrainPerStep = pSimulation.maxStrainPerStep();
+    parameters.mMaxSubSteps = pSimulation.maxSubSteps();
+    parameters.mMultirateThreshold = pSimulation.multirateThreshold();
+    parameters.mMultirateSubSteps = pSimulation.multirateSubSteps();
+    parameters.mCollisionRadius = pSimulation.collisionRadius();
+    parameters.mCollisionStiffness = pSimulation.collisionStiffness();
+    parameters.mCollisionDamping = pSimulation.collisionDamping();
+    parameters.mSpringCollisionRadius = pSimulation.springCollisionRadius();
+    parameters.mLongRangeTheta = pSimulation.longRangeTheta();
+    parameters.mFlags = 0;
+    if( pSimulation.propulsion() ) parameters.mFlags |= PropulsionFlag;
+    if( pSimulation.wind() ) parameters.mFlags |= WindFlag;
+    if( pSimulation.adaptiveTimeStep() ) parameters.mFlags |= AdaptiveTimeStepFlag;
+    if( pSimulation.multirate() ) parameters.mFlags |= MultirateFlag;
+    if( pSimulation.collision() ) parameters.mFlags |= CollisionFlag;
+    if( pSimulation.springCollision() ) parameters.mFlags |= SpringCollisionFlag;
+    if( pSimulation.longRange() ) parameters.mFlags |= LongRangeFlag;
+
+    return parameters;
+}
+
+template< unsigned int Dim >
+bool
+Snapshot<Dim>::records( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings, std::vector< MassPointRecord >& pMassRecords, std::vector< SpringRecord >& pSpringRecords )
+{
+    unsigned int massCount = pMassPoints.size();
+    unsigned int springCount = pSprings.size();
+
+    std::unordered_map< const MassPoint<Dim>*, uint32_t > massIndices;
+    massIndices.reserve( massCount );
+
+    pMassRecords.resize( massCount );
+
+    for(unsigned int pI=0; pI<massCount; ++pI)
+    {
+        const MassPoint<Dim>* mass = pMassPoints[pI];
+        MassPointRecord& record = pMassRecords[pI];
+
+        record.mMass = mass->mass();
+        record.mDrag = mass->drag();
+        for(unsigned int d=0; d<Dim; ++d) record.mPosition[d] = mass->position()[d];
+        for(unsigned int d=0; d<Dim; ++d) record.mVelocity[d] = mass->velocity()[d];
+
+        massIndices[mass] = pI;
+    }
+
+    pSpringRecords.resize( springCount );
+
+    for(unsigned int sI=0; sI<springCount; ++sI)
+    {
+        const Spring<Dim>* spring = pSprings[sI];
+        SpringRecord& record = pSpringRecords[sI];
+
+        auto massIter1 = massIndices.find( spring->massPoint1() );
+        auto massIter2 = massIndices.find( spring->massPoint2() );
+
+        if( massIter1 == massIndices.end() || massIter2 == massIndices.end() )
+        {
+            std::cout << "Snapshot: spring " << sI << " refers to a mass point that is not part of the simulation\n";
+            return false;
+        }
+
+        std::memset( &record, 0, sizeof( SpringRecord ) );
+        record.mType = PlainSpring;
+        record.mMassPoint1 = massIter1->second;
+        record.mMassPoint2 = massIter2->second;
+        record.mRestLength = spring->restLength();
+        record.mStiffness = spring->stiffness();
+        record.mDamping = spring->damping();
+
+        if( const AngledSpring<Dim>* angledSpring = dynamic_cast< const AngledSpring<Dim>* >( spring ) )
+        {
+            record.mType = AngledSpringType;
+            record.mRestAngle1 = angledSpring->restAngle1();
+            record.mRestAngle2 = angledSpring->restAngle2();
+            record.mAngleStiffness = angledSpring->angleStiffness();
+        }
+        else if( const DirSpring<Dim>* dirSpring = dynamic_cast< const DirSpring<Dim>* >( spring ) )
+        {
+            record.mType = DirSpringType;
+            for(unsigned int d=0; d<Dim; ++d) record.mRestDir[d] = dirSpring->restDir()[d];
+            record.mAngleStiffness = dirSpring->dirStiffness();
+        }
+    }
+
+    return true;
+}
+
+};
+
+};
@@ -0,0 +1,127 @@
+/** \file dab_spring_solver_chain.cpp
+*/
+
+#include "dab_spring_solver_chain.h"
+
+using namespace dab;
+using namespace dab::spring;
+
+#pragma mark ChainSolver implementation
+
+ChainSolver::ChainSolver()
+: mTimeStep(0.1)
+{}
+
+ChainSolver::~ChainSolver()
+{}
+
+float
+ChainSolver::timeStep() const
+{
+	return mTimeStep;
+}
+
+void
+ChainSolver::setTimeStep( float pTimeStep )
+{
+	mTimeStep = pTimeStep;
+}
+
+void
+ChainSolver::solve( const std::vector< MassPoint<1>* >& pMassPoints, const std::vector< Spring<1>* >& pSprings, float pDamping )
+{
+    // pSprings[i] connects pMassPoints[i] and pMassPoints[i+1]
+    // forces already stored in the mass points (gravity, external forces) are treated explicitly
+    
+    int massCount = pMassPoints.size();
+    int springCount = pSprings.size();
+    
+    if( massCount == 0 || springCount != massCount - 1 ) return;
+    
+    float h = mTimeStep;
+    float h2 = h * h;
+    
+    mLower.assign( massCount, 0.0 );
+    mDiagonal.resize( massCount );
+    mUpper.assign( massCount, 0.0 );
+    mRhs.resize( massCount );
+    
+    MassPoint<1>* mass;
+    Spring<1>* spring;
+    
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        mass = pMassPoints[pI];
+        
+        mDiagonal[pI] = mass->mass() + h * pDamping;
+        mRhs[pI] = mass->mass() * mass->velocity()[0] + h * mass->force()[0];
+    }
+    
+    float springForce;
+    float coupling;
+    
+    for(int sI=0; sI<springCount; ++sI)
+    {
+        spring = pSprings[sI];
+        
+        // elastic force on mass point 1 of the spring at the current configuration
+        springForce = spring->stiffness() * ( spring->length() - spring->restLength() ) * spring->direction()[0];
+        if( spring->massPoint1() != pMassPoints[sI] ) springForce *= -1.0;
+        
+        coupling = h * spring->damping() + h2 * spring->stiffness();
+        
+        mDiagonal[sI] += coupling;
+        mDiagonal[sI+1] += coupling;
+        mUpper[sI] -= coupling;
+        mLower[sI+1] -= coupling;
+        
+        mRhs[sI] += h * springForce;
+        mRhs[sI+1] -= h * springForce;
+    }
+    
+    // fixed mass points keep their state
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        if( pMassPoints[pI]->mass() > 0.0 ) continue;
+        
+        mDiagonal[pI] = 1.0;
+        mLower[pI] = 0.0;
+        mUpper[pI] = 0.0;
+        mRhs[pI] = 0.0;
+    }
+    
+    solveTridiagonal();
+    
+    for(int pI=0; pI<massCount; ++pI)
+    {
+        mass = pMassPoints[pI];
+        if( mass->mass() <= 0.0 ) continue;
+        
+        mass->backupVelocity()[0] = mRhs[pI];
+        mass->backupPosition()[0] = mass->position()[0] + h * mRhs[pI];
+    }
+}
+
+void
+ChainSolver::solveTridiagonal()
+{
+    // forward elimination and back substitution, the solution is stored in mRhs
+    // the system matrix is symmetric and diagonally dominant, no pivoting is needed
+    
+    int count = mDiagonal.size();
+    float factor;
+    
+    for(int i=1; i<count; ++i)
+    {
+        factor = mLower[i] / mDiagonal[i-1];
+        mDiagonal[i] -= factor * mUpper[i-1];
+        mRhs[i] -= factor * mRhs[i-1];
+    }
+    
+    mRhs[count-1] /= mDiagonal[count-1];
+    
+    for(int i=count-2; i>=0; --i)
+    {
+        mRhs[i] = ( mRhs[i] - mUpper[i] * mRhs[i+1] ) / mDiagonal[i];
+    }
+}
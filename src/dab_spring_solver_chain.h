@@ -0,0 +1,48 @@
+/** \file dab_spring_solver_chain.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <Eigen/Dense>
+#include "dab_singleton.h"
+#include "dab_spring_mass_point.h"
+#include "dab_spring_spring.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark ChainSolver Definition
+
+// implicit (backward euler) solver for linear chains of one-dimensional springs
+// the linearised system ( M + h C + h^2 K ) v' = M v + h f is tridiagonal and is solved with the thomas algorithm
+
+class ChainSolver : public Singleton< ChainSolver >
+{
+public:
+    ChainSolver();
+    ~ChainSolver();
+
+    float timeStep() const;
+    void setTimeStep( float pTimeStep );
+
+    void solve( const std::vector< MassPoint<1>* >& pMassPoints, const std::vector< Spring<1>* >& pSprings, float pDamping );
+
+protected:
+    float mTimeStep;
+
+    std::vector<float> mLower;
+    std::vector<float> mDiagonal;
+    std::vector<float> mUpper;
+    std::vector<float> mRhs;
+
+    void solveTridiagonal();
+};
+
+};
+
+};
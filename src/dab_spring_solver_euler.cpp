@@ -15,6 +15,12 @@ EulerSolver::EulerSolver()
 EulerSolver::~EulerSolver()
 {}
 
+float
+EulerSolver::timeStep() const
+{
+	return mTimeStep;
+}
+
 void
 EulerSolver::setTimeStep( float pTimeStep )
 {
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <Eigen/Dense>
 #include "dab_singleton.h"
+#include "dab_spring_solver_policy.h"
 
 namespace dab
 {
@@ -21,6 +22,7 @@ public:
     EulerSolver();
     ~EulerSolver();
     
+    float timeStep() const;
     void setTimeStep( float pTimeStep );
     
     template< unsigned int Dim > void solve( const Eigen::Matrix<float, Dim,1>& pInputPosition, const Eigen::Matrix<float, Dim,1>& pInputVelocity, const Eigen::Matrix<float, Dim,1>& pInputAcceleration, Eigen::Matrix<float, Dim,1>& pOutputPosition, Eigen::Matrix<float, Dim,1>& pOutputVelocity );
@@ -35,8 +37,7 @@ template< unsigned int Dim >
 void
 EulerSolver::solve( const Eigen::Matrix<float, Dim,1>& pInputPosition, const Eigen::Matrix<float, Dim,1>& pInputVelocity, const Eigen::Matrix<float, Dim,1>& pInputAcceleration, Eigen::Matrix<float, Dim,1>& pOutputPosition, Eigen::Matrix<float, Dim,1>& pOutputVelocity )
 {
-    pOutputVelocity = pInputVelocity + pInputAcceleration * mTimeStep;
-    pOutputPosition = pInputPosition + pInputVelocity * mTimeStep;
+    EulerKernel<Dim>::solve( mTimeStep, pInputPosition, pInputVelocity, pInputAcceleration, pOutputPosition, pOutputVelocity );
 }
 
 };
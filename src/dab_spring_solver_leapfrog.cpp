@@ -15,6 +15,12 @@ LeapFrogSolver::LeapFrogSolver()
 LeapFrogSolver::~LeapFrogSolver()
 {}
 
+float
+LeapFrogSolver::timeStep() const
+{
+	return mTimeStep;
+}
+
 void
 LeapFrogSolver::setTimeStep( float pTimeStep )
 {
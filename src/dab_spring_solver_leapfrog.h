@@ -6,6 +6,7 @@
 #include <iostream>
 #include <Eigen/Dense>
 #include "dab_singleton.h"
+#include "dab_spring_solver_policy.h"
 
 namespace dab
 {
@@ -21,6 +22,7 @@ public:
     LeapFrogSolver();
     ~LeapFrogSolver();
     
+    float timeStep() const;
     void setTimeStep( float pTimeStep );
     
     template< int Dim > void solve( const Eigen::Matrix<float, Dim,1>& pInputPosition, const Eigen::Matrix<float, Dim,1>& pInputVelocity, const Eigen::Matrix<float, Dim,1>& pInputAcceleration, Eigen::Matrix<float, Dim,1>& pOutputPosition, Eigen::Matrix<float, Dim,1>& pOutputVelocity );
@@ -37,8 +39,7 @@ LeapFrogSolver::solve( const Eigen::Matrix<float, Dim,1>& pInputPosition, const
 {
     //std::cout << "NumericalSolver::solve begin\n";
 
-    pOutputVelocity = pInputVelocity + pInputAcceleration * mTimeStep;
-    pOutputPosition = pInputPosition + pOutputVelocity * mTimeStep;
+    LeapFrogKernel<Dim>::solve( mTimeStep, pInputPosition, pInputVelocity, pInputAcceleration, pOutputPosition, pOutputVelocity );
     
     //if( pOutputPosition[1] < 0.0 ) pOutputPosition[1] = 0.0;
     
@@ -0,0 +1,7 @@
+/** \file dab_spring_solver_policy.cpp
+*/
+
+#include "dab_spring_solver_policy.h"
+
+using namespace dab;
+using namespace dab::spring;
@@ -0,0 +1,109 @@
+/** \file dab_spring_solver_policy.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <Eigen/Dense>
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark Solver Kernel Definition
+
+// stateless integration kernels
+// they are class templates so that they can be specialized for a particular dimension
+
+template< unsigned int Dim >
+struct EulerKernel
+{
+    static inline void solve( float pTimeStep, const Eigen::Matrix<float, Dim,1>& pInputPosition, const Eigen::Matrix<float, Dim,1>& pInputVelocity, const Eigen::Matrix<float, Dim,1>& pInputAcceleration, Eigen::Matrix<float, Dim,1>& pOutputPosition, Eigen::Matrix<float, Dim,1>& pOutputVelocity )
+    {
+        pOutputVelocity = pInputVelocity + pInputAcceleration * pTimeStep;
+        pOutputPosition = pInputPosition + pInputVelocity * pTimeStep;
+    }
+};
+
+template< unsigned int Dim >
+struct LeapFrogKernel
+{
+    static inline void solve( float pTimeStep, const Eigen::Matrix<float, Dim,1>& pInputPosition, const Eigen::Matrix<float, Dim,1>& pInputVelocity, const Eigen::Matrix<float, Dim,1>& pInputAcceleration, Eigen::Matrix<float, Dim,1>& pOutputPosition, Eigen::Matrix<float, Dim,1>& pOutputVelocity )
+    {
+        pOutputVelocity = pInputVelocity + pInputAcceleration * pTimeStep;
+        pOutputPosition = pInputPosition + pOutputVelocity * pTimeStep;
+    }
+};
+
+#pragma mark Solver Policy Definition
+
+struct EulerPolicy
+{
+    template< unsigned int Dim > using Kernel = EulerKernel<Dim>;
+};
+
+struct LeapFrogPolicy
+{
+    template< unsigned int Dim > using Kernel = LeapFrogKernel<Dim>;
+};
+
+#pragma mark PolicySolver Definition
+
+// binds a time step to a solver policy
+// instances are cheap and meant to be created per simulation or per call
+
+template< class Policy >
+class PolicySolver
+{
+public:
+    PolicySolver();
+    PolicySolver( float pTimeStep );
+
+    inline float timeStep() const;
+    inline void setTimeStep( float pTimeStep );
+
+    template< unsigned int Dim > inline void solve( const Eigen::Matrix<float, Dim,1>& pInputPosition, const Eigen::Matrix<float, Dim,1>& pInputVelocity, const Eigen::Matrix<float, Dim,1>& pInputAcceleration, Eigen::Matrix<float, Dim,1>& pOutputPosition, Eigen::Matrix<float, Dim,1>& pOutputVelocity );
+
+protected:
+    float mTimeStep;
+};
+
+#pragma mark PolicySolver Implementation
+
+template< class Policy >
+PolicySolver<Policy>::PolicySolver()
+: mTimeStep( 0.1 )
+{}
+
+template< class Policy >
+PolicySolver<Policy>::PolicySolver( float pTimeStep )
+: mTimeStep( pTimeStep )
+{}
+
+template< class Policy >
+float
+PolicySolver<Policy>::timeStep() const
+{
+    return mTimeStep;
+}
+
+template< class Policy >
+void
+PolicySolver<Policy>::setTimeStep( float pTimeStep )
+{
+    mTimeStep = pTimeStep;
+}
+
+template< class Policy >
+template< unsigned int Dim >
+void
+PolicySolver<Policy>::solve( const Eigen::Matrix<float, Dim,1>& pInputPosition, const Eigen::Matrix<float, Dim,1>& pInputVelocity, const Eigen::Matrix<float, Dim,1>& pInputAcceleration, Eigen::Matrix<float, Dim,1>& pOutputPosition, Eigen::Matrix<float, Dim,1>& pOutputVelocity )
+{
+    Policy::template Kernel<Dim>::solve( mTimeStep, pInputPosition, pInputVelocity, pInputAcceleration, pOutputPosition, pOutputVelocity );
+}
+
+};
+
+};
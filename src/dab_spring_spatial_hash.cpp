@@ -0,0 +1,7 @@
+/** \file dab_spring_spatial_hash.cpp
+*/
+
+#include "dab_spring_spatial_hash.h"
+
+using namespace dab;
+using namespace dab::spring;
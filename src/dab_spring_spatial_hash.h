@@ -0,0 +1,200 @@
+/** \file dab_spring_spatial_hash.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <Eigen/Dense>
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark SpatialHash Definition
+
+// uniform grid whose cells are hashed into a table that is filled by counting sort
+// rebuilding only touches flat arrays, there are no per cell allocations
+
+template< unsigned int Dim >
+class SpatialHash
+{
+public:
+    SpatialHash();
+    SpatialHash( float pCellSize );
+    ~SpatialHash();
+
+    float cellSize() const;
+    void setCellSize( float pCellSize );
+
+    void build( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions );
+    template< class Callback > void pairs( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions, float pRadius, Callback& pCallback ) const;
+
+protected:
+    float mCellSize;
+    unsigned int mTableSize;
+    std::vector< unsigned int > mCellStart;
+    std::vector< unsigned int > mCellEntries;
+    std::vector< unsigned int > mPointCells;
+    std::vector< Eigen::Matrix<float, Dim, 1> > mSortedPositions;
+    std::vector< Eigen::Matrix<int, Dim, 1> > mSortedCells;
+
+    inline Eigen::Matrix<int, Dim, 1> cell( const Eigen::Matrix<float, Dim, 1>& pPosition ) const;
+    inline unsigned int hash( const Eigen::Matrix<int, Dim, 1>& pCell ) const;
+};
+
+#pragma mark SpatialHash Implementation
+
+template< unsigned int Dim >
+SpatialHash<Dim>::SpatialHash()
+: mCellSize( 1.0 )
+, mTableSize( 0 )
+{}
+
+template< unsigned int Dim >
+SpatialHash<Dim>::SpatialHash( float pCellSize )
+: mCellSize( pCellSize )
+, mTableSize( 0 )
+{}
+
+template< unsigned int Dim >
+SpatialHash<Dim>::~SpatialHash()
+{}
+
+template< unsigned int Dim >
+float
+SpatialHash<Dim>::cellSize() const
+{
+    return mCellSize;
+}
+
+template< unsigned int Dim >
+void
+SpatialHash<Dim>::setCellSize( float pCellSize )
+{
+    mCellSize = pCellSize;
+}
+
+template< unsigned int Dim >
+Eigen::Matrix<int, Dim, 1>
+SpatialHash<Dim>::cell( const Eigen::Matrix<float, Dim, 1>& pPosition ) const
+{
+    return ( pPosition / mCellSize ).array().floor().template cast<int>();
+}
+
+template< unsigned int Dim >
+unsigned int
+SpatialHash<Dim>::hash( const Eigen::Matrix<int, Dim, 1>& pCell ) const
+{
+    static const unsigned int sPrimes[3] = { 73856093u, 19349663u, 83492791u };
+
+    unsigned int value = 0;
+    for(unsigned int d=0; d<Dim; ++d) value ^= static_cast<unsigned int>( pCell[d] ) * sPrimes[d % 3];
+
+    return value & ( mTableSize - 1 );
+}
+
+template< unsigned int Dim >
+void
+SpatialHash<Dim>::build( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions )
+{
+    unsigned int pointCount = pPositions.size();
+
+    // power of two table with at least twice as many buckets as points
+    unsigned int tableSize = 1;
+    while( tableSize < pointCount * 2 ) tableSize <<= 1;
+    mTableSize = tableSize;
+
+    mCellStart.assign( mTableSize + 1, 0 );
+    mCellEntries.resize( pointCount );
+    mPointCells.resize( pointCount );
+    mSortedPositions.resize( pointCount );
+    mSortedCells.resize( pointCount );
+
+    // count
+    for(unsigned int pI=0; pI<pointCount; ++pI)
+    {
+        mPointCells[pI] = hash( cell( pPositions[pI] ) );
+        mCellStart[ mPointCells[pI] + 1 ]++;
+    }
+
+    // prefix sum
+    for(unsigned int cI=0; cI<mTableSize; ++cI) mCellStart[cI+1] += mCellStart[cI];
+
+    // scatter, mCellStart is shifted by one bucket in the process and restored afterwards
+    for(unsigned int pI=0; pI<pointCount; ++pI) mCellEntries[ mCellStart[ mPointCells[pI] ]++ ] = pI;
+    for(unsigned int cI=mTableSize; cI>0; --cI) mCellStart[cI] = mCellStart[cI-1];
+    mCellStart[0] = 0;
+
+    // positions and cells in bucket order, entries of a bucket are read contiguously when querying
+    for(unsigned int eI=0; eI<pointCount; ++eI)
+    {
+        mSortedPositions[eI] = pPositions[ mCellEntries[eI] ];
+        mSortedCells[eI] = cell( mSortedPositions[eI] );
+    }
+}
+
+template< unsigned int Dim >
+template< class Callback >
+void
+SpatialHash<Dim>::pairs( const std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions, float pRadius, Callback& pCallback ) const
+{
+    // calls pCallback( i, j, distanceSquared ) once for each pair of points closer than pRadius
+    // pRadius must not exceed the cell size
+
+    unsigned int pointCount = pPositions.size();
+    if( pointCount == 0 || mTableSize == 0 ) return;
+
+    float radius2 = pRadius * pRadius;
+
+    const int neighbourCount = static_cast<int>( std::pow( 3, Dim ) );
+    std::vector< Eigen::Matrix<int, Dim, 1> > neighbourOffsets( neighbourCount );
+
+    for(int nI=0; nI<neighbourCount; ++nI)
+    {
+        int offsetIndex = nI;
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            neighbourOffsets[nI][d] = offsetIndex % 3 - 1;
+            offsetIndex /= 3;
+        }
+    }
+
+    // offsets nI and neighbourCount - 1 - nI point in opposite directions
+    // only the cell itself and the upper half of its neighbours are visited, which visits each pair of cells once
+    const int centerIndex = neighbourCount / 2;
+
+    Eigen::Matrix<int, Dim, 1> neighbourCell;
+
+    // points are visited in bucket order so that consecutive queries touch the same buckets
+    for(unsigned int eI=0; eI<pointCount; ++eI)
+    {
+        const Eigen::Matrix<float, Dim, 1>& position = mSortedPositions[eI];
+        const Eigen::Matrix<int, Dim, 1>& pointCell = mSortedCells[eI];
+
+        for(int nI=centerIndex; nI<neighbourCount; ++nI)
+        {
+            neighbourCell = pointCell + neighbourOffsets[nI];
+
+            unsigned int bucket = hash( neighbourCell );
+            unsigned int entryEnd = mCellStart[bucket + 1];
+
+            for(unsigned int nEI=mCellStart[bucket]; nEI<entryEnd; ++nEI)
+            {
+                // skip pairs within the same cell that have already been visited and entries of other cells that share the bucket
+                if( nI == centerIndex && nEI <= eI ) continue;
+                if( mSortedCells[nEI] != neighbourCell ) continue;
+
+                float distance2 = ( mSortedPositions[nEI] - position ).squaredNorm();
+                if( distance2 < radius2 ) pCallback( mCellEntries[eI], mCellEntries[nEI], distance2 );
+            }
+        }
+    }
+}
+
+};
+
+};
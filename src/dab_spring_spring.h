@@ -24,7 +24,7 @@ namespace dab
             Spring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2 );
             Spring( MassPoint<Dim>* pMassPoint1, MassPoint<Dim>* pMassPoint2, float pRestLength, float pStiffness, float pDamping );
             Spring( const Spring<Dim>& pSpring );
-            ~Spring();
+            virtual ~Spring();
             
             const Spring<Dim>& operator= ( const Spring<Dim>& pSpring );
             
@@ -333,6 +333,18 @@ namespace dab
             return ss.str();
         }
         
+#pragma mark Spring helpers
+        
+        // deletes springs owned by a caller together with their mass points
+        // a spring deletes its mass points once no spring references them, mass points without springs are deleted directly
+        template< unsigned int Dim >
+        void
+        deleteSprings( const std::vector< MassPoint<Dim>* >& pMassPoints, const std::vector< Spring<Dim>* >& pSprings )
+        {
+            for(auto massPoint : pMassPoints) if( massPoint->springs().size() == 0 ) delete massPoint;
+            for(auto spring : pSprings) delete spring;
+        }
+        
     };
     
 };
\ No newline at end of file
@@ -0,0 +1,180 @@
+/** \file dab_spring_tracer.cpp
+*/
+
+#include "dab_spring_tracer.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace dab;
+using namespace dab::spring;
+
+#pragma mark TraceBuffer implementation
+
+TraceBuffer::TraceBuffer( unsigned int pThreadIndex, unsigned int pCapacity )
+: mThreadIndex( pThreadIndex )
+, mEvents( std::max( pCapacity, 1u ) )
+, mWriteCount( 0 )
+, mReadStart( 0 )
+{}
+
+TraceBuffer::~TraceBuffer()
+{}
+
+unsigned int
+TraceBuffer::threadIndex() const
+{
+    return mThreadIndex;
+}
+
+unsigned int
+TraceBuffer::capacity() const
+{
+    return mEvents.size();
+}
+
+void
+TraceBuffer::events( std::vector< Event >& pEvents ) const
+{
+    unsigned long long capacity = mEvents.size();
+    unsigned long long writeCount = mWriteCount.load( std::memory_order_acquire );
+    unsigned long long readStart = std::max( mReadStart.load( std::memory_order_acquire ), writeCount > capacity ? writeCount - capacity : 0 );
+
+    std::vector< Event > events;
+    events.reserve( writeCount - readStart );
+
+    for(unsigned long long eI=readStart; eI<writeCount; ++eI) events.push_back( mEvents[ eI % capacity ] );
+
+    // the owning thread may have wrapped around while copying, those slots hold newer events
+    // the slot of event writeCountAfter may be in the middle of being written, so it counts as overwritten too
+    std::atomic_thread_fence( std::memory_order_acquire );
+    unsigned long long writeCountAfter = mWriteCount.load( std::memory_order_relaxed );
+    unsigned long long validStart = writeCountAfter + 1 > capacity ? writeCountAfter + 1 - capacity : 0;
+
+    for(unsigned long long eI=std::max( readStart, validStart ); eI<writeCount; ++eI) pEvents.push_back( events[ eI - readStart ] );
+}
+
+void
+TraceBuffer::clear()
+{
+    mReadStart.store( mWriteCount.load( std::memory_order_acquire ), std::memory_order_release );
+}
+
+#pragma mark Tracer implementation
+
+Tracer::Tracer()
+: mEnabled( true )
+, mCapacity( 65536 )
+, mOriginNs( now() )
+{}
+
+Tracer::~Tracer()
+{}
+
+bool
+Tracer::enabled() const
+{
+    return mEnabled.load( std::memory_order_relaxed );
+}
+
+unsigned int
+Tracer::capacity() const
+{
+    return mCapacity;
+}
+
+void
+Tracer::setEnabled( bool pEnabled )
+{
+    mEnabled.store( pEnabled, std::memory_order_relaxed );
+}
+
+void
+Tracer::setCapacity( unsigned int pCapacity )
+{
+    // only affects threads that record their first event afterwards
+    std::lock_guard< std::mutex > lock( mMutex );
+    mCapacity = std::max( pCapacity, 1u );
+}
+
+void
+Tracer::setThreadName( const std::string& pName )
+{
+    unsigned int threadIndex = threadBuffer().threadIndex();
+
+    std::lock_guard< std::mutex > lock( mMutex );
+    mThreadNames[threadIndex] = pName;
+}
+
+TraceBuffer*
+Tracer::registerThread()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    mBuffers.push_back( std::unique_ptr< TraceBuffer >( new TraceBuffer( mBuffers.size(), mCapacity ) ) );
+    mThreadNames.push_back( "thread " + std::to_string( mBuffers.size() - 1 ) );
+
+    return mBuffers.back().get();
+}
+
+std::string
+Tracer::json() const
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision( 3 );
+    ss << "{\n\"displayTimeUnit\": \"ns\",\n\"traceEvents\": [\n";
+
+    std::vector< TraceBuffer::Event > events;
+    bool first = true;
+
+    for(unsigned int bI=0; bI<mBuffers.size(); ++bI)
+    {
+        std::string threadName = mThreadNames[bI];
+        for(unsigned int cI=0; cI<threadName.size(); ++cI) if( threadName[cI] == '"' || threadName[cI] == '\\' ) threadName[cI] = '_';
+
+        ss << ( first ? "" : ",\n" ) << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << bI << ", \"args\": {\"name\": \"" << threadName << "\"}}";
+        first = false;
+
+        events.clear();
+        mBuffers[bI]->events( events );
+
+        for(auto& event : events)
+        {
+            double beginUs = ( static_cast<double>( event.mBeginNs ) - static_cast<double>( mOriginNs ) ) * 0.001;
+            double durationUs = static_cast<double>( event.mEndNs - event.mBeginNs ) * 0.001;
+
+            ss << ",\n{\"name\": \"" << event.mName << "\", \"cat\": \"dab_spring\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << bI << ", \"ts\": " << beginUs << ", \"dur\": " << durationUs << "}";
+        }
+    }
+
+    ss << "\n]\n}\n";
+
+    return ss.str();
+}
+
+bool
+Tracer::save( const std::string& pFileName ) const
+{
+    std::ofstream file( pFileName );
+
+    if( file.is_open() == false )
+    {
+        std::cout << "Tracer: could not open " << pFileName << "\n";
+        return false;
+    }
+
+    file << json();
+
+    return true;
+}
+
+void
+Tracer::clear()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    for(auto& buffer : mBuffers) buffer->clear();
+}
@@ -0,0 +1,163 @@
+/** \file dab_spring_tracer.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "dab_singleton.h"
+
+// timeline of the simulation phases per thread, only compiled into Simulation if DAB_SPRING_TRACE is defined
+// the scope name has to be a string literal or otherwise outlive the tracer
+
+#ifdef DAB_SPRING_TRACE
+#define DAB_SPRING_TRACE_CONCAT2( pA, pB ) pA##pB
+#define DAB_SPRING_TRACE_CONCAT( pA, pB ) DAB_SPRING_TRACE_CONCAT2( pA, pB )
+#define DAB_SPRING_TRACE_SCOPE( pName ) dab::spring::TraceScope DAB_SPRING_TRACE_CONCAT( traceScope, __LINE__ )( pName )
+#else
+#define DAB_SPRING_TRACE_SCOPE( pName )
+#endif
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark TraceBuffer Definition
+
+// ring buffer of the events of a single thread
+// only the owning thread writes, once full the oldest events are overwritten
+// readers copy the events without locking and drop the ones that were overwritten while copying
+
+class TraceBuffer
+{
+public:
+    struct Event
+    {
+        const char* mName;
+        unsigned long long mBeginNs;
+        unsigned long long mEndNs;
+    };
+
+    TraceBuffer( unsigned int pThreadIndex, unsigned int pCapacity );
+    ~TraceBuffer();
+
+    unsigned int threadIndex() const;
+    unsigned int capacity() const;
+
+    inline void add( const char* pName, unsigned long long pBeginNs, unsigned long long pEndNs );
+    void events( std::vector< Event >& pEvents ) const;
+    void clear();
+
+protected:
+    unsigned int mThreadIndex;
+    std::vector< Event > mEvents;
+    std::atomic< unsigned long long > mWriteCount;
+    std::atomic< unsigned long long > mReadStart;
+};
+
+#pragma mark Tracer Definition
+
+// collects the trace buffers of all threads that recorded events and writes them as Chrome trace json
+// (chrome://tracing or ui.perfetto.dev), buffers of finished threads are kept until the tracer is destroyed
+
+class Tracer : public Singleton< Tracer >
+{
+public:
+    Tracer();
+    ~Tracer();
+
+    bool enabled() const;
+    unsigned int capacity() const;
+    void setEnabled( bool pEnabled );
+    void setCapacity( unsigned int pCapacity );
+    void setThreadName( const std::string& pName );
+
+    static inline unsigned long long now();
+    static inline TraceBuffer& threadBuffer();
+
+    std::string json() const;
+    bool save( const std::string& pFileName ) const;
+    void clear();
+
+protected:
+    std::atomic< bool > mEnabled;
+    unsigned int mCapacity;
+    unsigned long long mOriginNs;
+
+    mutable std::mutex mMutex;
+    std::vector< std::unique_ptr< TraceBuffer > > mBuffers;
+    std::vector< std::string > mThreadNames;
+
+    TraceBuffer* registerThread();
+};
+
+#pragma mark TraceScope Definition
+
+// records a complete event spanning the lifetime of the scope into the buffer of the calling thread
+
+class TraceScope
+{
+public:
+    inline TraceScope( const char* pName );
+    inline ~TraceScope();
+
+protected:
+    const char* mName;
+    unsigned long long mBeginNs;
+};
+
+#pragma mark TraceBuffer Implementation
+
+void
+TraceBuffer::add( const char* pName, unsigned long long pBeginNs, unsigned long long pEndNs )
+{
+    unsigned long long writeCount = mWriteCount.load( std::memory_order_relaxed );
+
+    Event& event = mEvents[ writeCount % mEvents.size() ];
+    event.mName = pName;
+    event.mBeginNs = pBeginNs;
+    event.mEndNs = pEndNs;
+
+    mWriteCount.store( writeCount + 1, std::memory_order_release );
+}
+
+#pragma mark Tracer Implementation
+
+unsigned long long
+Tracer::now()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+TraceBuffer&
+Tracer::threadBuffer()
+{
+    // the tracer is only locked the first time a thread records an event
+    thread_local TraceBuffer* sBuffer = nullptr;
+    if( sBuffer == nullptr ) sBuffer = Tracer::get().registerThread();
+
+    return *sBuffer;
+}
+
+#pragma mark TraceScope Implementation
+
+TraceScope::TraceScope( const char* pName )
+: mName( Tracer::get().enabled() ? pName : nullptr )
+, mBeginNs( mName != nullptr ? Tracer::now() : 0 )
+{}
+
+TraceScope::~TraceScope()
+{
+    if( mName != nullptr ) Tracer::threadBuffer().add( mName, mBeginNs, Tracer::now() );
+}
+
+};
+
+};
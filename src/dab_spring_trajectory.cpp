@@ -0,0 +1,7 @@
+/** \file dab_spring_trajectory.cpp
+*/
+
+#include "dab_spring_trajectory.h"
+
+using namespace dab;
+using namespace dab::spring;
@@ -0,0 +1,684 @@
+/** \file dab_spring_trajectory.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <Eigen/Dense>
+#include "dab_spring_simulation.h"
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark Trajectory Definition
+
+// file layout of recorded trajectories
+// header, frames, keyframe index, footer
+// frame components are quantized to 64 bit integer multiples of the quantization step
+// keyframes store the quantized values, all other frames the difference to the previous frame
+// values are written as zigzag varints so that small differences take a single byte
+// components beyond +-sMaxQuantized steps are clamped and nan is stored as 0, such frames carry the ClampedFlag
+
+struct Trajectory
+{
+    static const uint32_t sVersion = 2;
+    static const int64_t sMaxQuantized = int64_t( 1 ) << 61;
+
+    enum FrameFlag
+    {
+        KeyframeFlag = 1 << 0,
+        ClampedFlag = 1 << 1
+    };
+
+    struct Header
+    {
+        char mMagic[4];
+        uint32_t mVersion;
+        uint32_t mDim;
+        uint32_t mVelocities;
+        float mPositionStep;
+        float mVelocityStep;
+        uint32_t mKeyframeInterval;
+        uint32_t mReserved;
+    };
+
+    struct FrameHeader
+    {
+        uint32_t mFlags;
+        uint32_t mPointCount;
+        uint32_t mByteCount;
+    };
+
+    struct Keyframe
+    {
+        uint64_t mFrame;
+        uint64_t mOffset;
+    };
+
+    struct Footer
+    {
+        uint64_t mIndexOffset;
+        uint64_t mFrameCount;
+        uint64_t mKeyframeCount;
+        char mMagic[4];
+        uint32_t mReserved;
+    };
+
+    static inline void writeVarint( std::vector< uint8_t >& pBytes, int64_t pValue )
+    {
+        uint64_t value = ( static_cast<uint64_t>( pValue ) << 1 ) ^ static_cast<uint64_t>( pValue >> 63 );
+
+        while( value >= 0x80 )
+        {
+            pBytes.push_back( static_cast<uint8_t>( value | 0x80 ) );
+            value >>= 7;
+        }
+
+        pBytes.push_back( static_cast<uint8_t>( value ) );
+    }
+
+    // returns false if the data ends within the varint or the varint is longer than 64 bits
+    static inline bool readVarint( const uint8_t*& pBytes, const uint8_t* pEnd, int64_t& pValue )
+    {
+        uint64_t value = 0;
+        int shift = 0;
+
+        while( pBytes < pEnd && shift < 64 )
+        {
+            uint8_t byte = *pBytes++;
+            value |= static_cast<uint64_t>( byte & 0x7f ) << shift;
+
+            if( ( byte & 0x80 ) == 0 )
+            {
+                pValue = static_cast<int64_t>( value >> 1 ) ^ -static_cast<int64_t>( value & 1 );
+                return true;
+            }
+
+            shift += 7;
+        }
+
+        return false;
+    }
+
+    static inline int64_t quantize( float pValue, double pScale, bool& pClamped )
+    {
+        double value = std::round( static_cast<double>( pValue ) * pScale );
+
+        if( value != value )
+        {
+            pClamped = true;
+            return 0;
+        }
+        if( std::abs( value ) > static_cast<double>( sMaxQuantized ) )
+        {
+            pClamped = true;
+            return value > 0.0 ? sMaxQuantized : -sMaxQuantized;
+        }
+
+        return static_cast<int64_t>( value );
+    }
+};
+
+#pragma mark TrajectoryRecorder Definition
+
+// appends a frame per call of record() to a file
+// record() only copies the state into a bounded queue, quantization, encoding and writing happen on a background thread
+// record() blocks while the queue is full so that no frame is lost
+
+template< unsigned int Dim >
+class TrajectoryRecorder
+{
+public:
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    bool isOpen() const;
+    uint64_t frameCount() const;
+
+    bool open( const std::string& pFileName, float pPositionStep, bool pVelocities = false, float pVelocityStep = 0.001, unsigned int pKeyframeInterval = 32, unsigned int pQueueCapacity = 8 );
+    void record( const Simulation<Dim>& pSimulation );
+    void close();
+
+protected:
+    struct Frame
+    {
+        std::vector< float > mPositions;
+        std::vector< float > mVelocities;
+    };
+
+    Trajectory::Header mHeader;
+    std::ofstream mFile;
+    unsigned int mQueueCapacity;
+    uint64_t mFrameCount;
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque< Frame > mQueue;
+    std::vector< Frame > mFreeFrames;
+    bool mClosing;
+
+    std::vector< int64_t > mPrevPositions;
+    std::vector< int64_t > mPrevVelocities;
+    std::vector< uint8_t > mBytes;
+    std::vector< Trajectory::Keyframe > mKeyframes;
+    uint64_t mWrittenFrames;
+
+    void run();
+    void write( const Frame& pFrame );
+    bool encode( const std::vector< float >& pValues, float pStep, bool pKeyframe, std::vector< int64_t >& pPrevValues );
+};
+
+typedef TrajectoryRecorder<2>  TrajectoryRecorder2D;
+typedef TrajectoryRecorder<3>  TrajectoryRecorder3D;
+
+#pragma mark TrajectoryReader Definition
+
+// reads frames recorded by a TrajectoryRecorder
+// seek() starts decoding at the closest preceding keyframe
+
+template< unsigned int Dim >
+class TrajectoryReader
+{
+public:
+    TrajectoryReader();
+    ~TrajectoryReader();
+
+    bool open( const std::string& pFileName );
+    void close();
+
+    bool velocities() const;
+    uint64_t frameCount() const;
+    uint64_t frame() const;
+    bool clamped() const;
+
+    bool seek( uint64_t pFrame );
+    bool read( std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions );
+    bool read( std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions, std::vector< Eigen::Matrix<float, Dim, 1> >& pVelocities );
+
+protected:
+    std::ifstream mFile;
+    Trajectory::Header mHeader;
+    Trajectory::Footer mFooter;
+    std::vector< Trajectory::Keyframe > mKeyframes;
+    uint64_t mFrame;
+    bool mClamped;
+
+    std::vector< int64_t > mPositions;
+    std::vector< int64_t > mVelocities;
+    std::vector< uint8_t > mBytes;
+
+    bool decodeNext();
+    bool decode( const uint8_t*& pBytes, const uint8_t* pEnd, bool pKeyframe, std::vector< int64_t >& pValues );
+};
+
+typedef TrajectoryReader<2>  TrajectoryReader2D;
+typedef TrajectoryReader<3>  TrajectoryReader3D;
+
+#pragma mark TrajectoryRecorder Implementation
+
+template< unsigned int Dim >
+TrajectoryRecorder<Dim>::TrajectoryRecorder()
+: mQueueCapacity( 8 )
+, mFrameCount( 0 )
+, mClosing( false )
+, mWrittenFrames( 0 )
+{
+    std::memset( &mHeader, 0, sizeof( Trajectory::Header ) );
+}
+
+template< unsigned int Dim >
+TrajectoryRecorder<Dim>::~TrajectoryRecorder()
+{
+    close();
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryRecorder<Dim>::isOpen() const
+{
+    return mThread.joinable();
+}
+
+template< unsigned int Dim >
+uint64_t
+TrajectoryRecorder<Dim>::frameCount() const
+{
+    return mFrameCount;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryRecorder<Dim>::open( const std::string& pFileName, float pPositionStep, bool pVelocities, float pVelocityStep, unsigned int pKeyframeInterval, unsigned int pQueueCapacity )
+{
+    close();
+
+    if( pPositionStep <= 0.0 || ( pVelocities && pVelocityStep <= 0.0 ) )
+    {
+        std::cout << "TrajectoryRecorder: quantization steps must be positive\n";
+        return false;
+    }
+
+    mFile.open( pFileName, std::ios::binary | std::ios::trunc );
+
+    if( mFile.is_open() == false )
+    {
+        std::cout << "TrajectoryRecorder: could not open " << pFileName << "\n";
+        return false;
+    }
+
+    std::memcpy( mHeader.mMagic, "DABT", 4 );
+    mHeader.mVersion = Trajectory::sVersion;
+    mHeader.mDim = Dim;
+    mHeader.mVelocities = pVelocities;
+    mHeader.mPositionStep = pPositionStep;
+    mHeader.mVelocityStep = pVelocities ? pVelocityStep : 0.0;
+    mHeader.mKeyframeInterval = std::max( pKeyframeInterval, 1u );
+
+    mFile.write( reinterpret_cast< const char* >( &mHeader ), sizeof( Trajectory::Header ) );
+
+    mQueueCapacity = std::max( pQueueCapacity, 1u );
+    mFrameCount = 0;
+    mWrittenFrames = 0;
+    mClosing = false;
+    mKeyframes.clear();
+    mPrevPositions.clear();
+    mPrevVelocities.clear();
+
+    mThread = std::thread( &TrajectoryRecorder<Dim>::run, this );
+
+    return true;
+}
+
+template< unsigned int Dim >
+void
+TrajectoryRecorder<Dim>::record( const Simulation<Dim>& pSimulation )
+{
+    if( isOpen() == false ) return;
+
+    const std::vector< MassPoint<Dim>* >& massPoints = pSimulation.massPoints();
+    int massCount = massPoints.size();
+
+    Frame frame;
+
+    {
+        std::unique_lock< std::mutex > lock( mMutex );
+        mCondition.wait( lock, [this]() { return mQueue.size() < mQueueCapacity; } );
+
+        // frames are recycled to avoid allocations while recording
+        if( mFreeFrames.size() > 0 )
+        {
+            frame = std::move( mFreeFrames.back() );
+            mFreeFrames.pop_back();
+        }
+    }
+
+    frame.mPositions.resize( massCount * Dim );
+    for(int pI=0; pI<massCount; ++pI) for(unsigned int d=0; d<Dim; ++d) frame.mPositions[pI * Dim + d] = massPoints[pI]->position()[d];
+
+    frame.mVelocities.resize( mHeader.mVelocities ? massCount * Dim : 0 );
+    if( mHeader.mVelocities ) for(int pI=0; pI<massCount; ++pI) for(unsigned int d=0; d<Dim; ++d) frame.mVelocities[pI * Dim + d] = massPoints[pI]->velocity()[d];
+
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mQueue.push_back( std::move( frame ) );
+    }
+
+    mCondition.notify_all();
+    mFrameCount++;
+}
+
+template< unsigned int Dim >
+void
+TrajectoryRecorder<Dim>::close()
+{
+    if( isOpen() == false ) return;
+
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mClosing = true;
+    }
+
+    mCondition.notify_all();
+    mThread.join();
+
+    // keyframe index and footer
+    Trajectory::Footer footer;
+    std::memset( &footer, 0, sizeof( Trajectory::Footer ) );
+    footer.mIndexOffset = mFile.tellp();
+    footer.mFrameCount = mWrittenFrames;
+    footer.mKeyframeCount = mKeyframes.size();
+    std::memcpy( footer.mMagic, "DABT", 4 );
+
+    mFile.write( reinterpret_cast< const char* >( mKeyframes.data() ), mKeyframes.size() * sizeof( Trajectory::Keyframe ) );
+    mFile.write( reinterpret_cast< const char* >( &footer ), sizeof( Trajectory::Footer ) );
+    mFile.close();
+
+    mQueue.clear();
+    mFreeFrames.clear();
+}
+
+template< unsigned int Dim >
+void
+TrajectoryRecorder<Dim>::run()
+{
+    Frame frame;
+
+    while( true )
+    {
+        {
+            std::unique_lock< std::mutex > lock( mMutex );
+            mCondition.wait( lock, [this]() { return mQueue.size() > 0 || mClosing; } );
+
+            if( mQueue.size() == 0 ) return;
+
+            frame = std::move( mQueue.front() );
+            mQueue.pop_front();
+        }
+
+        mCondition.notify_all();
+
+        write( frame );
+
+        std::lock_guard< std::mutex > lock( mMutex );
+        mFreeFrames.push_back( std::move( frame ) );
+    }
+}
+
+template< unsigned int Dim >
+void
+TrajectoryRecorder<Dim>::write( const Frame& pFrame )
+{
+    uint32_t pointCount = pFrame.mPositions.size() / Dim;
+
+    // a change of the point count always starts a keyframe
+    bool keyframe = mWrittenFrames % mHeader.mKeyframeInterval == 0 || pointCount * Dim != mPrevPositions.size();
+
+    mBytes.clear();
+    bool clamped = encode( pFrame.mPositions, mHeader.mPositionStep, keyframe, mPrevPositions );
+    if( mHeader.mVelocities ) clamped |= encode( pFrame.mVelocities, mHeader.mVelocityStep, keyframe, mPrevVelocities );
+
+    if( keyframe )
+    {
+        Trajectory::Keyframe index = { mWrittenFrames, static_cast<uint64_t>( mFile.tellp() ) };
+        mKeyframes.push_back( index );
+    }
+
+    uint32_t flags = ( keyframe ? Trajectory::KeyframeFlag : 0 ) | ( clamped ? Trajectory::ClampedFlag : 0 );
+    Trajectory::FrameHeader frameHeader = { flags, pointCount, static_cast<uint32_t>( mBytes.size() ) };
+
+    mFile.write( reinterpret_cast< const char* >( &frameHeader ), sizeof( Trajectory::FrameHeader ) );
+    mFile.write( reinterpret_cast< const char* >( mBytes.data() ), mBytes.size() );
+
+    mWrittenFrames++;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryRecorder<Dim>::encode( const std::vector< float >& pValues, float pStep, bool pKeyframe, std::vector< int64_t >& pPrevValues )
+{
+    // differences are taken between quantized values, the quantization error therefore does not accumulate
+    // quantized values are bounded by sMaxQuantized, so their differences can not overflow
+    // returns true if a value had to be clamped
+
+    int valueCount = pValues.size();
+    double scale = 1.0 / pStep;
+    bool clamped = false;
+
+    pPrevValues.resize( valueCount, 0 );
+
+    for(int vI=0; vI<valueCount; ++vI)
+    {
+        int64_t value = Trajectory::quantize( pValues[vI], scale, clamped );
+
+        Trajectory::writeVarint( mBytes, pKeyframe ? value : value - pPrevValues[vI] );
+        pPrevValues[vI] = value;
+    }
+
+    return clamped;
+}
+
+#pragma mark TrajectoryReader Implementation
+
+template< unsigned int Dim >
+TrajectoryReader<Dim>::TrajectoryReader()
+: mFrame( 0 )
+, mClamped( false )
+{
+    std::memset( &mHeader, 0, sizeof( Trajectory::Header ) );
+    std::memset( &mFooter, 0, sizeof( Trajectory::Footer ) );
+}
+
+template< unsigned int Dim >
+TrajectoryReader<Dim>::~TrajectoryReader()
+{
+    close();
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::open( const std::string& pFileName )
+{
+    close();
+
+    mFile.open( pFileName, std::ios::binary );
+
+    if( mFile.is_open() == false )
+    {
+        std::cout << "TrajectoryReader: could not open " << pFileName << "\n";
+        return false;
+    }
+
+    mFile.read( reinterpret_cast< char* >( &mHeader ), sizeof( Trajectory::Header ) );
+
+    if( mFile.good() == false || std::memcmp( mHeader.mMagic, "DABT", 4 ) != 0 || mHeader.mVersion != Trajectory::sVersion || mHeader.mDim != Dim )
+    {
+        std::cout << "TrajectoryReader: " << pFileName << " is not a trajectory of version " << Trajectory::sVersion << " and dimension " << Dim << "\n";
+        close();
+        return false;
+    }
+
+    mFile.seekg( -static_cast<std::streamoff>( sizeof( Trajectory::Footer ) ), std::ios::end );
+    mFile.read( reinterpret_cast< char* >( &mFooter ), sizeof( Trajectory::Footer ) );
+
+    if( mFile.good() == false || std::memcmp( mFooter.mMagic, "DABT", 4 ) != 0 )
+    {
+        std::cout << "TrajectoryReader: " << pFileName << " has no index, the recorder was not closed\n";
+        close();
+        return false;
+    }
+
+    mKeyframes.resize( mFooter.mKeyframeCount );
+    mFile.seekg( mFooter.mIndexOffset );
+    mFile.read( reinterpret_cast< char* >( mKeyframes.data() ), mKeyframes.size() * sizeof( Trajectory::Keyframe ) );
+
+    // forces seek() to start at the first keyframe
+    mFrame = std::numeric_limits<uint64_t>::max();
+
+    return seek( 0 );
+}
+
+template< unsigned int Dim >
+void
+TrajectoryReader<Dim>::close()
+{
+    if( mFile.is_open() ) mFile.close();
+
+    mFile.clear();
+    mKeyframes.clear();
+    mFooter.mFrameCount = 0;
+    mFrame = 0;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::velocities() const
+{
+    return mHeader.mVelocities;
+}
+
+template< unsigned int Dim >
+uint64_t
+TrajectoryReader<Dim>::frameCount() const
+{
+    return mFooter.mFrameCount;
+}
+
+template< unsigned int Dim >
+uint64_t
+TrajectoryReader<Dim>::frame() const
+{
+    return mFrame;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::clamped() const
+{
+    // true if values of the frame returned by the last read() were out of range or nan when recorded
+    return mClamped;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::seek( uint64_t pFrame )
+{
+    // the next read() returns frame pFrame
+
+    if( mKeyframes.size() == 0 )
+    {
+        mFrame = 0;
+        return pFrame == 0;
+    }
+    if( pFrame > mFooter.mFrameCount ) return false;
+
+    auto keyIter = std::upper_bound( mKeyframes.begin(), mKeyframes.end(), pFrame, []( uint64_t pValue, const Trajectory::Keyframe& pKeyframe ) { return pValue < pKeyframe.mFrame; } );
+    --keyIter;
+
+    // continue decoding if the requested frame lies ahead within the current keyframe interval
+    if( mFrame > pFrame || mFrame < keyIter->mFrame )
+    {
+        mFile.clear();
+        mFile.seekg( keyIter->mOffset );
+        mFrame = keyIter->mFrame;
+    }
+
+    while( mFrame < pFrame ) if( decodeNext() == false ) return false;
+
+    return true;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::read( std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions )
+{
+    std::vector< Eigen::Matrix<float, Dim, 1> > velocities;
+    return read( pPositions, velocities );
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::read( std::vector< Eigen::Matrix<float, Dim, 1> >& pPositions, std::vector< Eigen::Matrix<float, Dim, 1> >& pVelocities )
+{
+    if( mFrame >= mFooter.mFrameCount || decodeNext() == false ) return false;
+
+    int pointCount = mPositions.size() / Dim;
+
+    pPositions.resize( pointCount );
+    for(int pI=0; pI<pointCount; ++pI) for(unsigned int d=0; d<Dim; ++d) pPositions[pI][d] = mPositions[pI * Dim + d] * mHeader.mPositionStep;
+
+    pVelocities.resize( mHeader.mVelocities ? pointCount : 0 );
+    if( mHeader.mVelocities ) for(int pI=0; pI<pointCount; ++pI) for(unsigned int d=0; d<Dim; ++d) pVelocities[pI][d] = mVelocities[pI * Dim + d] * mHeader.mVelocityStep;
+
+    return true;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::decodeNext()
+{
+    Trajectory::FrameHeader frameHeader;
+    mFile.read( reinterpret_cast< char* >( &frameHeader ), sizeof( Trajectory::FrameHeader ) );
+
+    // after a failure mFrame is invalid so that the next seek() restarts at a keyframe
+
+    mBytes.resize( frameHeader.mByteCount );
+    if( mFile.good() ) mFile.read( reinterpret_cast< char* >( mBytes.data() ), mBytes.size() );
+
+    if( mFile.good() == false )
+    {
+        std::cout << "TrajectoryReader: could not read frame " << mFrame << "\n";
+        mFrame = std::numeric_limits<uint64_t>::max();
+        return false;
+    }
+
+    // every value takes at least one byte, the check also guards the allocations against corrupt point counts
+    uint64_t valueCount = static_cast<uint64_t>( frameHeader.mPointCount ) * Dim * ( mHeader.mVelocities ? 2 : 1 );
+    bool keyframe = frameHeader.mFlags & Trajectory::KeyframeFlag;
+    bool valid = valueCount <= mBytes.size();
+
+    const uint8_t* bytes = mBytes.data();
+    const uint8_t* end = bytes + mBytes.size();
+
+    if( valid )
+    {
+        mPositions.resize( frameHeader.mPointCount * Dim, 0 );
+        valid = decode( bytes, end, keyframe, mPositions );
+    }
+    if( valid && mHeader.mVelocities )
+    {
+        mVelocities.resize( frameHeader.mPointCount * Dim, 0 );
+        valid = decode( bytes, end, keyframe, mVelocities );
+    }
+
+    if( valid == false || bytes != end )
+    {
+        std::cout << "TrajectoryReader: frame " << mFrame << " is corrupt\n";
+        mFrame = std::numeric_limits<uint64_t>::max();
+        return false;
+    }
+
+    mClamped = frameHeader.mFlags & Trajectory::ClampedFlag;
+    mFrame++;
+
+    return true;
+}
+
+template< unsigned int Dim >
+bool
+TrajectoryReader<Dim>::decode( const uint8_t*& pBytes, const uint8_t* pEnd, bool pKeyframe, std::vector< int64_t >& pValues )
+{
+    // differences are added without signed overflow so that corrupt data can not cause undefined behaviour
+
+    int valueCount = pValues.size();
+    int64_t value;
+
+    for(int vI=0; vI<valueCount; ++vI)
+    {
+        if( Trajectory::readVarint( pBytes, pEnd, value ) == false ) return false;
+
+        if( pKeyframe ) pValues[vI] = value;
+        else pValues[vI] = static_cast<int64_t>( static_cast<uint64_t>( pValues[vI] ) + static_cast<uint64_t>( value ) );
+    }
+
+    return true;
+}
+
+};
+
+};
@@ -0,0 +1,7 @@
+/** \file dab_spring_wind_field.cpp
+*/
+
+#include "dab_spring_wind_field.h"
+
+using namespace dab;
+using namespace dab::spring;
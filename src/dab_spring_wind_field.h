@@ -0,0 +1,306 @@
+/** \file dab_spring_wind_field.h
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+
+namespace dab
+{
+
+namespace spring
+{
+
+#pragma mark WindField Definition
+
+// time varying wind velocity: uniform flow plus gusts from value noise
+// the noise is evaluated once per update on the nodes of a coarse grid that covers the given bounds
+// and is sampled multilinearly per position, positions outside of the grid are clamped to its border
+
+template< unsigned int Dim >
+class WindField
+{
+public:
+    WindField();
+    ~WindField();
+
+    const Eigen::Matrix<float, Dim, 1>& flow() const;
+    float gustStrength() const;
+    float gustScale() const;
+    float gustFrequency() const;
+    unsigned int resolution() const;
+    void setFlow( const Eigen::Matrix<float, Dim, 1>& pFlow );
+    void setGustStrength( float pGustStrength );
+    void setGustScale( float pGustScale );
+    void setGustFrequency( float pGustFrequency );
+    void setResolution( unsigned int pResolution );
+
+    void update( float pTime, const Eigen::Matrix<float, Dim, 1>& pMinCorner, const Eigen::Matrix<float, Dim, 1>& pMaxCorner );
+    inline Eigen::Matrix<float, Dim, 1> sample( const Eigen::Matrix<float, Dim, 1>& pPosition ) const;
+
+protected:
+    Eigen::Matrix<float, Dim, 1> mFlow;
+    float mGustStrength;
+    float mGustScale;
+    float mGustFrequency;
+    unsigned int mResolution;
+
+    Eigen::Matrix<float, Dim, 1> mOrigin;
+    Eigen::Matrix<float, Dim, 1> mCellSize;
+    Eigen::Matrix<int, Dim, 1> mStrides;
+    std::vector< Eigen::Matrix<float, Dim, 1> > mVelocities;
+
+    inline float lattice( const Eigen::Matrix<int, Dim, 1>& pCell, int pSlice, int pComponent ) const;
+    float noise( const Eigen::Matrix<float, Dim, 1>& pPosition, int pSlice, int pComponent ) const;
+};
+
+typedef WindField<2>  WindField2D;
+typedef WindField<3>  WindField3D;
+
+#pragma mark WindField Implementation
+
+template< unsigned int Dim >
+WindField<Dim>::WindField()
+: mFlow( Eigen::Matrix<float, Dim, 1>::Constant( 0.0 ) )
+, mGustStrength( 0.0 )
+, mGustScale( 10.0 )
+, mGustFrequency( 0.1 )
+, mResolution( 8 )
+, mOrigin( Eigen::Matrix<float, Dim, 1>::Constant( 0.0 ) )
+, mCellSize( Eigen::Matrix<float, Dim, 1>::Constant( 1.0 ) )
+{}
+
+template< unsigned int Dim >
+WindField<Dim>::~WindField()
+{}
+
+template< unsigned int Dim >
+const Eigen::Matrix<float, Dim, 1>&
+WindField<Dim>::flow() const
+{
+    return mFlow;
+}
+
+template< unsigned int Dim >
+float
+WindField<Dim>::gustStrength() const
+{
+    return mGustStrength;
+}
+
+template< unsigned int Dim >
+float
+WindField<Dim>::gustScale() const
+{
+    return mGustScale;
+}
+
+template< unsigned int Dim >
+float
+WindField<Dim>::gustFrequency() const
+{
+    return mGustFrequency;
+}
+
+template< unsigned int Dim >
+unsigned int
+WindField<Dim>::resolution() const
+{
+    return mResolution;
+}
+
+template< unsigned int Dim >
+void
+WindField<Dim>::setFlow( const Eigen::Matrix<float, Dim, 1>& pFlow )
+{
+    mFlow = pFlow;
+}
+
+template< unsigned int Dim >
+void
+WindField<Dim>::setGustStrength( float pGustStrength )
+{
+    mGustStrength = pGustStrength;
+}
+
+template< unsigned int Dim >
+void
+WindField<Dim>::setGustScale( float pGustScale )
+{
+    mGustScale = pGustScale;
+}
+
+template< unsigned int Dim >
+void
+WindField<Dim>::setGustFrequency( float pGustFrequency )
+{
+    mGustFrequency = pGustFrequency;
+}
+
+template< unsigned int Dim >
+void
+WindField<Dim>::setResolution( unsigned int pResolution )
+{
+    // the grid no longer matches the strides, sample() returns the mean flow until the next update()
+    mResolution = std::max( pResolution, 2u );
+    mVelocities.clear();
+}
+
+template< unsigned int Dim >
+float
+WindField<Dim>::lattice( const Eigen::Matrix<int, Dim, 1>& pCell, int pSlice, int pComponent ) const
+{
+    // integer hash of lattice coordinates mapped to [-1, 1]
+
+    unsigned int value = static_cast<unsigned int>( pSlice ) * 2654435761u + static_cast<unsigned int>( pComponent ) * 2246822519u;
+    for(unsigned int d=0; d<Dim; ++d) value = ( value ^ static_cast<unsigned int>( pCell[d] ) ) * 3266489917u + 374761393u;
+
+    value ^= value >> 15;
+    value *= 2246822519u;
+    value ^= value >> 13;
+
+    return static_cast<float>( value & 0xffffff ) / static_cast<float>( 0x7fffff ) - 1.0;
+}
+
+template< unsigned int Dim >
+float
+WindField<Dim>::noise( const Eigen::Matrix<float, Dim, 1>& pPosition, int pSlice, int pComponent ) const
+{
+    Eigen::Matrix<int, Dim, 1> cell;
+    Eigen::Matrix<float, Dim, 1> fraction;
+
+    for(unsigned int d=0; d<Dim; ++d)
+    {
+        float coord = pPosition[d] / mGustScale;
+        cell[d] = static_cast<int>( std::floor( coord ) );
+        fraction[d] = coord - cell[d];
+        fraction[d] = fraction[d] * fraction[d] * ( 3.0 - 2.0 * fraction[d] );
+    }
+
+    float value = 0.0;
+
+    for(int corner=0; corner<(1 << Dim); ++corner)
+    {
+        Eigen::Matrix<int, Dim, 1> cornerCell = cell;
+        float weight = 1.0;
+
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            if( ( corner >> d ) & 1 )
+            {
+                cornerCell[d] += 1;
+                weight *= fraction[d];
+            }
+            else
+            {
+                weight *= 1.0 - fraction[d];
+            }
+        }
+
+        value += weight * lattice( cornerCell, pSlice, pComponent );
+    }
+
+    return value;
+}
+
+template< unsigned int Dim >
+void
+WindField<Dim>::update( float pTime, const Eigen::Matrix<float, Dim, 1>& pMinCorner, const Eigen::Matrix<float, Dim, 1>& pMaxCorner )
+{
+    // the grid is refit to the bounds on every update, noise is evaluated in world space so refitting does not make the wind jump
+
+    int nodeCount = 1;
+    for(unsigned int d=0; d<Dim; ++d)
+    {
+        mStrides[d] = nodeCount;
+        nodeCount *= mResolution;
+    }
+
+    mOrigin = pMinCorner;
+    mCellSize = ( ( pMaxCorner - pMinCorner ) / static_cast<float>( mResolution - 1 ) ).cwiseMax( 0.0001f );
+    mVelocities.resize( nodeCount );
+
+    if( mGustStrength == 0.0 )
+    {
+        std::fill( mVelocities.begin(), mVelocities.end(), mFlow );
+        return;
+    }
+
+    // gusts blend between two noise slices, the slices advance with time
+    float slicePosition = pTime * mGustFrequency;
+    int slice = static_cast<int>( std::floor( slicePosition ) );
+    float sliceBlend = slicePosition - slice;
+    sliceBlend = sliceBlend * sliceBlend * ( 3.0 - 2.0 * sliceBlend );
+
+    Eigen::Matrix<float, Dim, 1> nodePosition;
+
+    for(int nI=0; nI<nodeCount; ++nI)
+    {
+        int nodeIndex = nI;
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            nodePosition[d] = mOrigin[d] + mCellSize[d] * ( nodeIndex % mResolution );
+            nodeIndex /= mResolution;
+        }
+
+        Eigen::Matrix<float, Dim, 1>& velocity = mVelocities[nI];
+
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            velocity[d] = noise( nodePosition, slice, d ) * ( 1.0 - sliceBlend ) + noise( nodePosition, slice + 1, d ) * sliceBlend;
+        }
+
+        velocity = mFlow + velocity * mGustStrength;
+    }
+}
+
+template< unsigned int Dim >
+Eigen::Matrix<float, Dim, 1>
+WindField<Dim>::sample( const Eigen::Matrix<float, Dim, 1>& pPosition ) const
+{
+    if( mVelocities.size() == 0 ) return mFlow;
+
+    Eigen::Matrix<int, Dim, 1> cell;
+    Eigen::Matrix<float, Dim, 1> fraction;
+
+    for(unsigned int d=0; d<Dim; ++d)
+    {
+        float coord = std::max( 0.0f, std::min( ( pPosition[d] - mOrigin[d] ) / mCellSize[d], static_cast<float>( mResolution - 1 ) ) );
+        cell[d] = std::min( static_cast<int>( coord ), static_cast<int>( mResolution ) - 2 );
+        fraction[d] = coord - cell[d];
+    }
+
+    int baseIndex = cell.dot( mStrides );
+    Eigen::Matrix<float, Dim, 1> velocity = Eigen::Matrix<float, Dim, 1>::Constant( 0.0 );
+
+    for(int corner=0; corner<(1 << Dim); ++corner)
+    {
+        int index = baseIndex;
+        float weight = 1.0;
+
+        for(unsigned int d=0; d<Dim; ++d)
+        {
+            if( ( corner >> d ) & 1 )
+            {
+                index += mStrides[d];
+                weight *= fraction[d];
+            }
+            else
+            {
+                weight *= 1.0 - fraction[d];
+            }
+        }
+
+        velocity += mVelocities[index] * weight;
+    }
+
+    return velocity;
+}
+
+};
+
+};